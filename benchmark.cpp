@@ -0,0 +1,271 @@
+// MIT License
+//
+// Copyright (c) 2020 degski
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// Usage: benchmark [max_size [ops]]
+//
+// Every container is built from max_size random keys (sizes 1K .. 100M by
+// powers of 10, the build is reported per key) after which each operation is
+// timed over ops calls (10'000 by default). Inserts are balanced by the erases and pops that follow, so all
+// operations run against a container of (roughly) the stated size.
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+
+#include <algorithm>
+#include <iomanip>
+#include <limits>
+#include <memory>
+#include <queue>
+#include <random>
+#include <sax/iostream.hpp>
+#include <sax/splitmix.hpp>
+#include <sax/uniform_int_distribution.hpp>
+#include <set>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include <plf/plf_nanotimer.h>
+
+#include "beap.hpp"
+#include "beap_view.hpp"
+
+namespace bench {
+
+using key_type = int;
+
+// The adapters give all contenders one interface, operations a container
+// does not support (searching a priority queue) are flagged and skipped.
+
+template<typename Storage>
+inline constexpr char const * beap_name = "beap";
+template<>
+inline constexpr char const * beap_name<tri::cache_line_tiled> = "beap (line tiles)";
+template<>
+inline constexpr char const * beap_name<tri::page_tiled> = "beap (page tiles)";
+template<>
+inline constexpr char const * beap_name<tri::segmented<>> = "beap (segmented)";
+template<>
+inline constexpr char const * beap_name<tri::virtual_memory<>> = "beap (virtual mem)";
+template<>
+inline constexpr char const * beap_name<tri::padded> = "beap (padded)";
+
+template<typename Storage, typename Search = tri::branchy_search>
+struct beap_adapter {
+    static constexpr char const * name = std::is_same_v<Search, tri::branchless_search> ? "beap (branchless)" : beap_name<Storage>;
+    static constexpr bool searchable   = true;
+
+    using beap_type = beap<key_type, int32_t, std::less<int32_t>, Storage, Search>;
+
+    void fill ( std::vector<key_type> const & k_ ) { b = beap_type::build ( k_ ); }
+    void insert ( key_type k_ ) { b.insert ( k_ ); }
+    [[nodiscard]] bool contains ( key_type k_ ) const noexcept { return b.contains ( k_ ); }
+    void contains_batch ( std::vector<key_type> const & k_, std::vector<std::uint64_t> & m_ ) const { b.contains_batch ( k_, m_ ); }
+    void erase ( key_type k_ ) noexcept { b.erase ( k_ ); }
+    [[nodiscard]] key_type top ( ) const noexcept { return b.top ( ).v; }
+    [[nodiscard]] key_type pop ( ) noexcept { return b.pop_beap ( ); }
+
+    beap_type b;
+};
+
+struct beap_view_adapter {
+    static constexpr char const * name = "beap_view";
+    static constexpr bool searchable   = true;
+
+    beap_view_adapter ( ) : b ( data ) {}
+
+    void fill ( std::vector<key_type> const & k_ ) {
+        data = k_;
+        b.make_beap ( );
+    }
+    void insert ( key_type k_ ) { b.insert ( k_ ); }
+    [[nodiscard]] bool contains ( key_type k_ ) const noexcept { return b.contains ( k_ ); }
+    void contains_batch ( std::vector<key_type> const & k_, std::vector<std::uint64_t> & m_ ) const { b.contains_batch ( k_, m_ ); }
+    void erase ( key_type k_ ) noexcept { b.erase ( k_ ); }
+    [[nodiscard]] key_type top ( ) const noexcept { return b.top ( ).v; }
+    [[nodiscard]] key_type pop ( ) noexcept { return b.pop_beap ( ); }
+
+    std::vector<key_type> data;
+    beap_view<key_type> b;
+};
+
+struct priority_queue_adapter {
+    static constexpr char const * name = "std::priority_queue";
+    static constexpr bool searchable   = false;
+
+    void fill ( std::vector<key_type> const & k_ ) { q = std::priority_queue<key_type> ( k_.begin ( ), k_.end ( ) ); }
+    void insert ( key_type k_ ) { q.push ( k_ ); }
+    [[nodiscard]] bool contains ( key_type ) const noexcept { return false; }
+    void erase ( key_type ) noexcept {}
+    [[nodiscard]] key_type top ( ) const noexcept { return q.top ( ); }
+    [[nodiscard]] key_type pop ( ) noexcept {
+        key_type t = q.top ( );
+        q.pop ( );
+        return t;
+    }
+
+    std::priority_queue<key_type> q;
+};
+
+struct multiset_adapter {
+    static constexpr char const * name = "std::multiset";
+    static constexpr bool searchable   = true;
+
+    void fill ( std::vector<key_type> const & k_ ) { s.insert ( k_.begin ( ), k_.end ( ) ); }
+    void insert ( key_type k_ ) { s.insert ( k_ ); }
+    [[nodiscard]] bool contains ( key_type k_ ) const noexcept { return s.find ( k_ ) != s.end ( ); }
+    void erase ( key_type k_ ) noexcept {
+        if ( auto it = s.find ( k_ ); it != s.end ( ) )
+            s.erase ( it );
+    }
+    [[nodiscard]] key_type top ( ) const noexcept { return *s.rbegin ( ); }
+    [[nodiscard]] key_type pop ( ) noexcept {
+        auto it    = std::prev ( s.end ( ) );
+        key_type t = *it;
+        s.erase ( it );
+        return t;
+    }
+
+    std::multiset<key_type> s;
+};
+
+struct sorted_vector_adapter {
+    static constexpr char const * name = "sorted std::vector";
+    static constexpr bool searchable   = true;
+
+    void fill ( std::vector<key_type> const & k_ ) {
+        v = k_;
+        std::sort ( v.begin ( ), v.end ( ) );
+    }
+    void insert ( key_type k_ ) { v.insert ( std::upper_bound ( v.begin ( ), v.end ( ), k_ ), k_ ); }
+    [[nodiscard]] bool contains ( key_type k_ ) const noexcept { return std::binary_search ( v.begin ( ), v.end ( ), k_ ); }
+    void erase ( key_type k_ ) noexcept {
+        if ( auto it = std::lower_bound ( v.begin ( ), v.end ( ), k_ ); it != v.end ( ) and *it == k_ )
+            v.erase ( it );
+    }
+    [[nodiscard]] key_type top ( ) const noexcept { return v.back ( ); }
+    [[nodiscard]] key_type pop ( ) noexcept {
+        key_type t = v.back ( );
+        v.pop_back ( );
+        return t;
+    }
+
+    std::vector<key_type> v;
+};
+
+inline volatile key_type sink = 0;
+
+struct workload {
+    std::vector<key_type> fill, insert, lookup;
+};
+
+[[nodiscard]] inline workload make_workload ( std::size_t size_, std::size_t ops_, sax::splitmix64 & rng_ ) {
+    sax::uniform_int_distribution<key_type> dis{ 0, std::numeric_limits<key_type>::max ( ) };
+    workload w;
+    w.fill.resize ( size_ );
+    w.insert.resize ( ops_ );
+    w.lookup.resize ( ops_ );
+    std::generate ( w.fill.begin ( ), w.fill.end ( ), [ & ] { return dis ( rng_ ); } );
+    std::generate ( w.insert.begin ( ), w.insert.end ( ), [ & ] { return dis ( rng_ ); } );
+    // Half of the lookups hit, half of them (almost certainly) miss.
+    sax::uniform_int_distribution<std::size_t> dis_idx{ 0, size_ - 1 };
+    for ( std::size_t i = 0; i < ops_; ++i )
+        w.lookup[ i ] = i & 1 ? dis ( rng_ ) : w.fill[ dis_idx ( rng_ ) ];
+    return w;
+}
+
+inline void report ( char const * container_, std::size_t size_, char const * op_, double ns_, std::size_t ops_ ) {
+    double ns_op = ns_ / static_cast<double> ( ops_ );
+    std::cout << std::left << std::setw ( 20 ) << container_ << std::right << std::setw ( 12 ) << size_ << std::setw ( 10 ) << op_
+              << std::fixed << std::setprecision ( 1 ) << std::setw ( 14 ) << ns_op << std::setprecision ( 0 ) << std::setw ( 16 )
+              << ( 1.0e9 / ns_op ) << nl;
+}
+
+template<typename Adapter, typename Function>
+void time_op ( Adapter & a_, std::size_t size_, char const * op_, std::vector<key_type> const & keys_, Function f_ ) {
+    plf::nanotimer t;
+    t.start ( );
+    for ( key_type k : keys_ )
+        f_ ( a_, k );
+    report ( Adapter::name, size_, op_, t.get_elapsed_ns ( ), keys_.size ( ) );
+}
+
+template<typename Adapter>
+void run ( workload const & w_ ) {
+    std::size_t const size = w_.fill.size ( );
+    // Some of the adapters are not movable (beap_view refers to its own data).
+    auto a = std::make_unique<Adapter> ( );
+    plf::nanotimer t;
+    t.start ( );
+    a->fill ( w_.fill );
+    report ( Adapter::name, size, "build", t.get_elapsed_ns ( ), size );
+    time_op ( *a, size, "insert", w_.insert, [] ( Adapter & a_, key_type k_ ) { a_.insert ( k_ ); } );
+    time_op ( *a, size, "top", w_.lookup, [] ( Adapter & a_, key_type ) { sink = a_.top ( ); } );
+    if constexpr ( Adapter::searchable ) {
+        time_op ( *a, size, "find", w_.lookup, [] ( Adapter & a_, key_type k_ ) { sink = a_.contains ( k_ ); } );
+        // All lookups in one call, reported per key.
+        if constexpr ( requires ( Adapter & a_, std::vector<std::uint64_t> & m_ ) { a_.contains_batch ( w_.lookup, m_ ); } ) {
+            std::vector<std::uint64_t> found ( ( w_.lookup.size ( ) + 63 ) / 64 );
+            t.start ( );
+            a->contains_batch ( w_.lookup, found );
+            report ( Adapter::name, size, "batch", t.get_elapsed_ns ( ), w_.lookup.size ( ) );
+            sink = static_cast<key_type> ( found[ 0 ] );
+        }
+        time_op ( *a, size, "erase", w_.insert, [] ( Adapter & a_, key_type k_ ) { a_.erase ( k_ ); } );
+    }
+    time_op ( *a, size, "pop", w_.lookup, [] ( Adapter & a_, key_type ) { sink = a_.pop ( ); } );
+}
+
+} // namespace bench
+
+int main ( int argc_, char ** argv_ ) {
+
+    std::size_t const max_size = argc_ > 1 ? std::stoull ( argv_[ 1 ] ) : 100'000'000;
+    std::size_t const ops      = argc_ > 2 ? std::stoull ( argv_[ 2 ] ) : 10'000;
+
+    sax::splitmix64 rng{ [] ( ) {
+        std::random_device rdev;
+        return ( static_cast<std::size_t> ( rdev ( ) ) << 32 ) | static_cast<std::size_t> ( rdev ( ) );
+    }( ) };
+
+    std::cout << std::left << std::setw ( 20 ) << "container" << std::right << std::setw ( 12 ) << "size" << std::setw ( 10 ) << "op"
+              << std::setw ( 14 ) << "ns/op" << std::setw ( 16 ) << "ops/sec" << nl;
+
+    for ( std::size_t size = 1'000; size <= max_size; size *= 10 ) {
+        bench::workload const w = bench::make_workload ( size, std::min ( size, ops ), rng );
+        bench::run<bench::beap_adapter<tri::vector_storage>> ( w );
+        bench::run<bench::beap_adapter<tri::vector_storage, tri::branchless_search>> ( w );
+        bench::run<bench::beap_adapter<tri::cache_line_tiled>> ( w );
+        bench::run<bench::beap_adapter<tri::page_tiled>> ( w );
+        bench::run<bench::beap_adapter<tri::segmented<>>> ( w );
+        bench::run<bench::beap_adapter<tri::virtual_memory<>>> ( w );
+        bench::run<bench::beap_adapter<tri::padded>> ( w );
+        bench::run<bench::beap_view_adapter> ( w );
+        bench::run<bench::priority_queue_adapter> ( w );
+        bench::run<bench::multiset_adapter> ( w );
+        bench::run<bench::sorted_vector_adapter> ( w );
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -1,4 +1,3 @@
-
 // MIT License
 //
 // Copyright (c) 2020 degski
@@ -21,15 +20,25 @@
 // OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 // SOFTWARE.
 
+#pragma once
+
 #include <cassert>
 #include <cstddef>
 #include <cstdint>
 #include <cstdlib>
 
+#include <algorithm>
+#include <bit>
 #include <compare>
+#include <execution>
+#include <functional>
+#include <iterator>
 #include <limits>
+#include <memory>
+#include <numeric>
 #include <optional>
 #include <span>
+#include <stdexcept>
 #include <tuple>
 #include <type_traits>
 #include <utility>
@@ -41,14 +50,27 @@
 #define BEAP_UNPREDICTABLE HEDLEY_UNPREDICTABLE
 #define BEAP_LIKELY HEDLEY_LIKELY
 #define BEAP_UNLIKELY HEDLEY_UNLIKELY
+#if defined( _MSC_VER ) && not defined( __clang__ )
+#    include <intrin.h>
+#    define BEAP_PREFETCH( p ) _mm_prefetch ( reinterpret_cast<char const *> ( p ), _MM_HINT_T0 )
+#else
+#    define BEAP_PREFETCH( p ) __builtin_prefetch ( p )
+#endif
 
 #include "detail/triangular.hpp"
+#include "detail/policies.hpp"
+#include "detail/search.hpp"
+#include "detail/simd_search.hpp"
+#include "detail/walk.hpp"
+#include "detail/storage.hpp"
+#include "detail/virtual_storage.hpp"
 
 #define ever                                                                                                                       \
     ;                                                                                                                              \
     ;
 
-template<typename ValueType, typename SignedSizeType = int32_t, typename Compare = std::less<SignedSizeType>>
+template<typename ValueType, typename SignedSizeType = int32_t, typename Compare = std::less<SignedSizeType>,
+         typename Storage = tri::vector_storage, typename Search = tri::branchy_search, typename Projection = std::identity, typename Tracker = tri::untracked>
 class beap {
 
     // Current beap_height of beap. Note that beap_height is defined as
@@ -60,22 +82,51 @@ class beap {
     //    0   1   2   3   4   5   6   7   8   9  10  11  12  13  14  15  16  17  18  19  20  21  22  23  24  25  26  27 28 29 30 ..
     // { 72, 68, 63, 44, 62, 55, 33, 22, 32, 51, 13, 18, 21, 19, 22, 11, 12, 14, 17,  9, 13,  3,  2, 10, 54 }
     //    _   _       _           _               _                   _                       _                          _
+    //
+    // The Storage policy decides on the memory lay-out, tri::vector_storage
+    // stores the above, tri::cache_line_tiled and tri::page_tiled store tiles
+    // of the matrix view contiguously, tri::segmented<> allocates groups of
+    // rows separately and never copies on growth (see detail/storage.hpp),
+    // tri::virtual_memory<> commits pages of a reserved address range on
+    // demand (see detail/virtual_storage.hpp), tri::padded completes the last
+    // row with the lowest value, which takes the length checks out of search
+    // and bubble_down.
 
     public:
     using size_type = SignedSizeType;
 
     private:
-    template<typename T, typename Comp>
+    template<typename T, typename Comp, typename Proj>
     struct basic_value_type {
 
         T v;
 
-        constexpr basic_value_type ( T value_ ) noexcept : v{ value_ } {}
+        constexpr basic_value_type ( ) noexcept = default;
+        constexpr basic_value_type ( T value_ ) noexcept : v{ std::move ( value_ ) } {}
+        // Constructs the value in place, from the arguments of emplace ( ).
+        template<typename... Args>
+        constexpr basic_value_type ( std::in_place_t, Args &&... args_ ) : v ( std::forward<Args> ( args_ )... ) {}
+
+        // The key compared, the projection of the value (the value itself by default).
+        [[nodiscard]] constexpr decltype ( auto ) key ( ) const noexcept { return std::invoke ( Proj ( ), v ); }
 
+        // A single call of a three-way Comp, two of a less-than one (see detail/search.hpp).
         [[nodiscard]] constexpr size_type operator<=> ( basic_value_type const & r_ ) const noexcept {
-            return static_cast<size_type> ( static_cast<int> ( not( Comp ( ) ( r_.v, v ) ) ) -
-                                            static_cast<int> ( Comp ( ) ( v, r_.v ) ) );
+            return static_cast<size_type> ( tri::three_way<Comp> ( key ( ), r_.key ( ) ) );
         };
+        [[nodiscard]] constexpr bool operator== ( basic_value_type const & r_ ) const noexcept {
+            return not tri::three_way<Comp> ( key ( ), r_.key ( ) );
+        };
+        // A single call either way.
+        [[nodiscard]] constexpr bool operator< ( basic_value_type const & r_ ) const noexcept {
+            return tri::less_than<Comp> ( key ( ), r_.key ( ) );
+        }
+        [[nodiscard]] constexpr bool operator> ( basic_value_type const & r_ ) const noexcept {
+            return tri::less_than<Comp> ( r_.key ( ), key ( ) );
+        }
+
+        // The value ordered before all others, the padding of tri::padded.
+        [[nodiscard]] static constexpr basic_value_type lowest ( ) noexcept { return { tri::lowest<T, Comp> ( ) }; }
 
         template<typename Stream>
         [[maybe_unused]] friend Stream & operator<< ( Stream & out_, basic_value_type const & value_ ) noexcept {
@@ -84,10 +135,14 @@ class beap {
         }
     };
 
-    using value_type     = basic_value_type<ValueType, Compare>;
-    using container_type = std::vector<value_type>;
+    using value_type     = basic_value_type<ValueType, Compare, Projection>;
+    using container_type = typename Storage::template type<value_type, size_type>;
 
     public:
+    // Compare orders the keys, the projections of the values (as in the std::ranges
+    // algorithms), a beap of records compares only their key field that way, with
+    // f.e. Projection = tri::member<&job::deadline>. The lookups take a key.
+    using key_type               = std::remove_cvref_t<std::invoke_result_t<Projection, ValueType const &>>;
     using difference_type        = size_type;
     using reference              = typename container_type::reference;
     using const_reference        = typename container_type::const_reference;
@@ -101,15 +156,25 @@ class beap {
     private:
     using span_type = tri::basic_span_type<size_type>;
 
+    // The last row is complete, the slots beyond length ( ) hold value_type::lowest ( ).
+    static constexpr bool padded = tri::is_padded_v<container_type>;
+    static_assert ( not padded or std::is_same_v<Projection, std::identity>, "tri::padded pads with the lowest key, it takes no projection" );
+
     public:
     beap ( ) noexcept        = default;
     beap ( beap const & b_ ) = default;
     beap ( beap && b_ )      = default;
 
+    // Constructing from a range builds the beap in O ( n log n ), see make_beap ( ).
     template<typename ForwardIt>
-    beap ( ForwardIt b_, ForwardIt e_ ) :
-        data ( b_, e_ ),
-        end_span ( span_type::span ( tri::nth_triangular_root ( static_cast<size_type> ( data.size ( ) ) ) - 1 ) ) {}
+    beap ( ForwardIt b_, ForwardIt e_ ) : data ( b_, e_ ) {
+        make_beap ( );
+    }
+    template<typename ExecutionPolicy, typename ForwardIt,
+             typename = std::enable_if_t<std::is_execution_policy_v<std::remove_cvref_t<ExecutionPolicy>>>>
+    beap ( ExecutionPolicy && policy_, ForwardIt b_, ForwardIt e_ ) : data ( b_, e_ ) {
+        make_beap ( std::forward<ExecutionPolicy> ( policy_ ) );
+    }
 
     [[maybe_unused]] beap & operator= ( beap const & b_ ) = default;
     [[maybe_unused]] beap & operator= ( beap && b_ ) = default;
@@ -117,37 +182,81 @@ class beap {
     // Operations (private).
 
     private:
-    [[nodiscard]] span_type search ( value_type const & v ) const noexcept {
-        span_type s           = end_span;
-        size_type beap_height = s.end - s.beg, i = s.beg + 1, h = beap_height, len = length ( );
+    [[nodiscard]] span_type search ( key_type const & v ) const noexcept {
+        if constexpr ( std::is_same_v<Search, tri::branchless_search> )
+            return search_branchless ( v );
+        else if constexpr ( simd_searchable )
+            return search_simd ( v );
+        else
+            return tri::search<padded> ( compare_to ( v ), end_span, length ( ) );
+    }
+
+    // The three-way comparison of v_ with element i (of row s), for the walks of detail/walk.hpp.
+    [[nodiscard]] auto compare_to ( key_type const & v_ ) const noexcept {
+        return [ this, &v_ ] ( size_type i_, span_type const & s_ ) noexcept { return tri::three_way<Compare> ( v_, refof ( i_, s_ ).key ( ) ); };
+    }
+
+    // The scalar walk, in which steps down-right followed by steps up hand over
+    // to the vectorized scan along the row (see detail/simd_search.hpp).
+    // Measured on random ints (ns/key, 100K / 1M / 10M keys): scalar 1570 /
+    // 5760 / 22600, AVX2 1220 / 3790 / 13860, AVX-512 970 / 3450 / 13280.
+    static constexpr bool simd_searchable = tri::simd::enabled_v<ValueType, Compare> and std::is_same_v<Projection, std::identity> and std::contiguous_iterator<iterator>;
+
+    [[nodiscard]] span_type search_simd ( key_type const & v ) const noexcept {
+        ValueType const * const p = reinterpret_cast<ValueType const *> ( std::to_address ( data.begin ( ) ) );
+        size_type const len       = length ( );
+        return tri::search_scanning<padded> (
+            compare_to ( v ),
+            [ p, len, &v ] ( size_type i_, size_type h_, size_type e_ ) noexcept {
+                return tri::simd::scan<tri::simd::order_v<ValueType, Compare>> ( p, len, i_, h_, e_, v );
+            },
+            end_span, len );
+    }
+
+    // The walk of search ( ), of which the moves are selected with conditional
+    // moves instead of branches (see detail/search.hpp). Measured on random
+    // ints (ns/key, 100K / 1M / 10M keys): branchy 1550 / 5070 / 20400,
+    // branchless 1550 / 5170 / 19430, the branchy walk is better predicted
+    // than its three-way switch suggests.
+    static_assert ( not std::is_same_v<Search, tri::branchless_search> or std::is_trivially_copyable_v<key_type>,
+                    "the branchless search requires trivially copyable keys" );
+
+    [[nodiscard]] span_type search_branchless ( key_type const & v ) const noexcept {
+        span_type s = end_span;
+        size_type i = s.beg, h = s.end - s.beg, len = length ( );
+        if ( BEAP_UNLIKELY ( not len ) )
+            return { len, h };
         for ( ever ) {
-            switch ( value_type const & d = data[ i ]; BEAP_UNPREDICTABLE ( v <=> d ) ) {
-                case -1: {
-                    if ( BEAP_UNLIKELY ( i == ( len - 1 ) ) ) {
-                        --s, i -= h--;
-                        continue;
-                    }
-                    if ( size_type i_ = i + h + 2; BEAP_UNLIKELY ( i_ < len ) ) {
-                        ++s, i = i_, h += 1;
-                        continue;
-                    }
-                    if ( BEAP_UNLIKELY ( i++ == ( s.end - 1 ) ) )
-                        return { end_span.end, beap_height };
-                    continue;
-                }
-                case +1: {
-                    if ( BEAP_UNLIKELY ( i == s.end ) )
-                        return { end_span.end, beap_height };
-                    --s, i -= h--;
-                    continue;
-                }
-                default: {
+            value_type const & d = refof ( i, s );
+            int const c   = tri::three_way<Compare> ( v, d.key ( ) );
+            bool const lt = c < 0, gt = c > 0;
+            if ( BEAP_UNLIKELY ( not( lt | gt ) ) )
+                return { padded and i >= len ? len : i, h };
+            // Down-right or up, the (rare) moves along the border are left to search_step ( ).
+            size_type const j = lt ? i + h + 2 : i - h, g = lt ? h + 1 : h - 1, b = lt ? s.end + 1 : s.beg - h;
+            if ( BEAP_UNLIKELY ( lt ? ( padded ? s.end == end_span.end : j >= len ) : i == s.end ) ) {
+                if ( search_step ( v, s, i, h, len ) )
                     return { i, h };
-                }
+                continue;
             }
+            i = j, h = g, s = { b, b + g };
         }
     }
 
+    // One step of the staircase walk of search ( ), returns true when the
+    // walk is done, i_ then holds the index found (or length ( ) on a miss).
+    [[nodiscard]] bool search_step ( key_type const & v_, span_type & s_, size_type & i_, size_type & h_,
+                                     size_type len_ ) const noexcept {
+        return tri::search_step<padded> ( compare_to ( v_ ), s_, i_, h_, len_, end_span );
+    }
+
+    // See tri::search_batch ( ).
+    template<std::size_t Group, typename Done>
+    void search_batch ( std::span<key_type const> keys_, Done done_ ) const {
+        tri::search_batch<Group, padded, Compare> (
+            const_layout{ *this }, end_span, length ( ), keys_, [ this ] ( key_type const & k_ ) noexcept { return search ( k_ ).beg; }, done_ );
+    }
+
     [[nodiscard]] size_type breadth_first_search ( value_type const & v_ ) noexcept {
         size_type siz = size ( );
         for ( size_type base_l = 0, base_i = tri::nth_triangular ( base_l ); BEAP_UNLIKELY ( base_i < siz );
@@ -163,142 +272,246 @@ class beap {
         return siz;
     }
 
+    // The walks of detail/walk.hpp, over the elements, telling the tracker of every move.
+    template<typename Beap>
+    struct basic_layout {
+        Beap & b;
+        [[nodiscard]] BEAP_PURE decltype ( auto ) at ( size_type i_, span_type const & s_ ) const noexcept { return b.refof ( i_, s_ ); }
+        [[nodiscard]] static decltype ( auto ) key ( value_type const & e_ ) noexcept { return e_.key ( ); }
+        void placed ( size_type i_, span_type const & s_ ) const noexcept { b.placed ( i_, s_ ); }
+    };
+    using layout       = basic_layout<beap>;
+    using const_layout = basic_layout<beap const>;
+
     [[maybe_unused]] size_type bubble_up ( size_type i_, size_type h_ ) noexcept {
-        span_type s = end_span;
-        while ( BEAP_LIKELY ( h_ ) ) {
-            span_type p = s.prev ( );
-            size_type d = i_ - s.beg;
-            size_type l = 0, r = 0;
-            if ( BEAP_UNLIKELY ( i_ != s.beg ) )
-                l = p.beg + d - 1;
-            if ( BEAP_UNLIKELY ( i_ != s.end ) )
-                r = p.beg + d;
-            if ( BEAP_UNPREDICTABLE ( ( l ) and ( refof ( i_ ) > refof ( l ) ) and ( not r or ( refof ( l ) < refof ( r ) ) ) ) ) {
-                std::swap ( refof ( i_ ), refof ( l ) );
-                i_ = l;
-            }
-            else if ( BEAP_UNPREDICTABLE ( ( r ) and ( refof ( i_ ) > refof ( r ) ) ) ) {
-                std::swap ( refof ( i_ ), refof ( r ) );
-                i_ = r;
-            }
-            else {
-                return i_;
-            }
-            s = p;
-            h_ -= 1;
-        }
-        assert ( i_ == 0 );
-        return i_;
+        layout l{ *this };
+        return tri::sift_up<Compare, tri::sift_prefetch_distance> ( l, i_, h_, tri::sift_prefetches ( length ( ) ) );
     }
 
     [[nodiscard]] size_type bubble_down ( size_type i_, size_type h_ ) noexcept {
-        span_type s         = end_span;
-        size_type const h_1 = s.end - s.beg - 1, len = length ( );
-        while ( BEAP_LIKELY ( h_ < h_1 ) ) {
-            span_type c = s.next ( );
-            size_type l = c.beg + i_ - s.beg, r = 0;
-            if ( BEAP_LIKELY ( l < len ) ) {
-                r = l + 1;
-                if ( BEAP_UNLIKELY ( r >= len ) )
-                    r = 0;
-            }
-            else {
-                l = 0;
-            }
-            if ( BEAP_UNPREDICTABLE ( l and refof ( i_ ) < refof ( l ) and ( not r or refof ( l ) > refof ( r ) ) ) ) {
-                std::swap ( refof ( i_ ), refof ( l ) );
-                i_ = l;
-            }
-            else if ( BEAP_UNPREDICTABLE ( r and refof ( i_ ) < refof ( r ) ) ) {
-                std::swap ( refof ( i_ ), refof ( r ) );
-                i_ = r;
-            }
-            else {
-                return i_;
-            }
-            s = c;
-            h_ += 1;
-        }
-        return i_;
+        layout l{ *this };
+        return tri::sift_down<Compare, padded, tri::sift_prefetch_distance> ( l, i_, h_, end_span.end - end_span.beg, length ( ), tri::sift_prefetches ( length ( ) ) );
     }
 
     [[maybe_unused]] void erase_impl ( size_type i_, size_type h_ ) noexcept {
         size_type len = length ( );
-        if ( BEAP_UNLIKELY ( len == end_span.beg ) ) {
+        if ( BEAP_UNLIKELY ( ( len - 1 ) == end_span.beg ) ) {
             --end_span;
-            shrink_to_fit ( ); // only when load is less than 50%.
+            if ( BEAP_UNLIKELY ( size ( ) <= ( capacity ( ) >> 1 ) ) ) // Only when load is 50% or less.
+                shrink_to_fit ( );
         }
-        assert ( i_ != ( len - 1 ) );
-        refof ( i_ ) = pop_data ( );
+        if ( BEAP_UNLIKELY ( i_ == ( len - 1 ) ) ) {
+            data.pop_back ( );
+            return;
+        }
+        refof ( i_, span_type::span ( h_ ) ) = pop_data ( );
         if ( size_type i = bubble_down ( i_, h_ ); BEAP_LIKELY ( i == i_ ) )
             bubble_up ( i_, h_ );
     }
 
     template<typename... Args>
-    [[maybe_unused]] size_type emplace_impl ( size_type i_, Args... args_ ) noexcept {
-        data.emplace_back ( std::forward<Args> ( args_ )... );
+    [[maybe_unused]] size_type emplace_impl ( size_type i_, Args &&... args_ ) {
+        data.emplace_back ( std::in_place, std::forward<Args> ( args_ )... );
         return bubble_up ( i_, end_span.end - end_span.beg );
     }
 
+    // Appends the whole batch, after which the new elements are bubbled up in
+    // order (in the same rows as the appends, so nothing is evicted in between),
+    // or, if that is more expensive, the beap is rebuilt.
+    template<typename ForwardIt>
+    void emplace_batch ( ForwardIt b_, ForwardIt e_ ) {
+        size_type const n = length ( ), k = static_cast<size_type> ( std::distance ( b_, e_ ) );
+        data.reserve ( static_cast<typename container_type::size_type> ( tri::nth_triangular_ceil ( n + k ) ) );
+        for ( ; b_ != e_; ++b_ )
+            data.emplace_back ( *b_ );
+        end_span = span_type::span ( tri::nth_triangular_root ( n + k ) - 1 );
+        if ( BEAP_UNLIKELY ( tri::rebuild_is_cheaper ( n, k ) ) ) {
+            make_beap ( );
+            return;
+        }
+        size_type h = tri::nth_triangular_root ( n + 1 ) - 1;
+        for ( size_type i = n, e = tri::nth_triangular ( h + 1 ); i < n + k; ++i ) {
+            if ( BEAP_UNLIKELY ( i == e ) )
+                e += ++h + 1;
+            bubble_up ( i, h );
+        }
+    }
+
     // Operations (public).
 
     public:
-    [[maybe_unused]] size_type insert ( value_type const & v_ ) { return emplace ( value_type{ v_ } ); }
+    [[maybe_unused]] size_type insert ( value_type const & v_ ) { return emplace ( v_.v ); }
+    [[maybe_unused]] size_type insert ( value_type && v_ ) { return emplace ( std::move ( v_.v ) ); }
+    // Batches are appended as a whole and repaired in one pass, see emplace_batch.
     template<typename ForwardIt>
-    void insert ( ForwardIt b_, ForwardIt e_ ) noexcept {
-        data.reserve ( static_cast<typename container_type::size_type> (
-            tri::nth_triangular_ceil ( static_cast<size_type> ( data.size ( ) + std::distance ( b_, e_ ) ) ) ) );
-        size_type c = size ( );
-        while ( b_ != e_ )
-            emplace_impl ( c++, value_type{ *b_ } );
+    void insert ( ForwardIt b_, ForwardIt e_ ) {
+        emplace_batch ( b_, e_ );
     }
 
     // clang-format on
 
+    // Constructs the value in place, from args_ (forwarded to the constructor of ValueType).
     template<typename... Args>
-    [[maybe_unused]] size_type emplace ( Args... args_ ) {
+    [[maybe_unused]] size_type emplace ( Args &&... args_ ) {
         size_type i = length ( );
-        if ( BEAP_UNLIKELY ( i == end_span.end ) ) {
+        if ( BEAP_UNLIKELY ( i > end_span.end ) ) {
             ++end_span;
-            data.reserve ( end_span.end );
+            data.reserve ( end_span.end + 1 );
         }
         return emplace_impl ( i, std::forward<Args> ( args_ )... );
     }
     template<typename ForwardIt>
-    [[maybe_unused]] void emplace ( ForwardIt b_, ForwardIt e_ ) noexcept {
-        data.reserve ( static_cast<typename container_type::size_type> (
-            tri::nth_triangular_ceil ( static_cast<size_type> ( data.size ( ) + std::distance ( b_, e_ ) ) ) ) );
-        size_type c = size ( );
-        while ( b_ != e_ )
-            emplace_impl ( c++, std::move ( *b_ ) );
+    [[maybe_unused]] void emplace ( ForwardIt b_, ForwardIt e_ ) {
+        emplace_batch ( std::make_move_iterator ( b_ ), std::make_move_iterator ( e_ ) );
     }
 
+    void erase ( key_type const & k_ ) noexcept {
+        auto [ i, h ] = search ( k_ );
+        if ( BEAP_UNLIKELY ( i == length ( ) ) )
+            return;
+        erase_impl ( i, h );
+    }
     void erase ( value_type const & v_ ) noexcept {
-        auto [ i, h ] = search ( v_ );
-        if ( BEAP_UNLIKELY ( i == end_span.end ) )
+        auto [ i, h ] = search ( v_.key ( ) );
+        if ( BEAP_UNLIKELY ( i == length ( ) ) )
             return;
         erase_impl ( i, h );
     }
     void erase_by_index ( size_type i_ ) noexcept {
-        if ( BEAP_UNLIKELY ( i_ == end_span.end ) )
+        if ( BEAP_UNLIKELY ( i_ >= length ( ) ) )
             return;
-        erase_impl ( i_, tri::nth_triangular_root ( i_ ) );
+        erase_impl ( i_, tri::nth_triangular_root ( i_ + 1 ) - 1 );
+    }
+
+    // Erases every element with key k_, and returns how many, see tri::erase_all ( ).
+    [[maybe_unused]] size_type erase_all ( key_type const & k_ ) {
+        return tri::erase_all<Compare> ( *this, k_, [ this, &k_ ] {
+            size_type w = 0;
+            for ( size_type i = 0, n = length ( ); i < n; ++i )
+                if ( tri::three_way<Compare> ( refof ( i ).key ( ), k_ ) ) {
+                    if ( w != i )
+                        refof ( w ) = std::move ( refof ( i ) );
+                    ++w;
+                }
+            while ( length ( ) > w )
+                data.pop_back ( );
+            make_beap ( );
+        } );
+    }
+
+    // Replaces element i_ by v_, which is sifted up or down from there, as its
+    // key went up or down, in one sift instead of the two of an erase and an
+    // insert. Returns the index v_ ends up at. Measured on random ints (ns,
+    // 100K / 1M keys): erase_by_index ( ) and insert ( ) 2850 / 8060, update
+    // ( ) 1430 / 4970.
+    [[maybe_unused]] size_type update ( size_type i_, value_type v_ ) noexcept {
+        assert ( i_ < length ( ) );
+        size_type const h = tri::nth_triangular_root ( i_ + 1 ) - 1;
+        span_type const s = span_type::span ( h );
+        bool const up     = v_ > refof ( i_, s );
+        refof ( i_, s ) = std::move ( v_ );
+        return up ? bubble_up ( i_, h ) : bubble_down ( i_, h );
     }
 
-    [[nodiscard]] size_type find ( value_type const & v_ ) const noexcept { return search ( v_ ).beg; }
-    [[nodiscard]] bool contains ( value_type const & v_ ) const noexcept { return find ( v_ ) != end_span.end; }
+    [[nodiscard]] size_type find ( key_type const & k_ ) const noexcept { return search ( k_ ).beg; }
+    [[nodiscard]] size_type find ( value_type const & v_ ) const noexcept { return search ( v_.key ( ) ).beg; }
+    [[nodiscard]] bool contains ( value_type const & v_ ) const noexcept { return find ( v_ ) != length ( ); }
+
+    // Batched lookups, see tri::search_batch ( ).
+    template<std::size_t Group = 1>
+    void find_batch ( std::span<key_type const> keys_, std::span<size_type> out_ ) const {
+        assert ( out_.size ( ) >= keys_.size ( ) );
+        search_batch<Group> ( keys_, [ out_ ] ( std::size_t k_, size_type i_ ) noexcept { out_[ k_ ] = i_; } );
+    }
+    // Sets bit k of the bitmap iff keys_[ k ] is found, the bitmap holds at least ( size + 63 ) / 64 words.
+    template<std::size_t Group = 1>
+    void contains_batch ( std::span<key_type const> keys_, std::span<std::uint64_t> bitmap_ ) const {
+        assert ( bitmap_.size ( ) >= ( keys_.size ( ) + 63 ) / 64 );
+        std::fill_n ( bitmap_.begin ( ), ( keys_.size ( ) + 63 ) / 64, std::uint64_t{ 0 } );
+        search_batch<Group> ( keys_, [ bitmap_, len = length ( ) ] ( std::size_t k_, size_type i_ ) noexcept {
+            bitmap_[ k_ >> 6 ] |= std::uint64_t{ i_ != len } << ( k_ & 63 );
+        } );
+    }
+
+
+    // Calls f_ with every element in [ lo_, hi_ ] (lo_ not ordered after hi_ by
+    // Compare), see tri::for_each_in_range ( ).
+    template<typename Fn>
+    void for_each_in_range ( key_type const & lo_, key_type const & hi_, Fn f_ ) const {
+        tri::for_each_in_range<Compare> ( const_layout{ *this }, end_span, length ( ), lo_, hi_, [ &f_ ] ( value_type const & e_ ) { f_ ( e_.v ); } );
+    }
+    // A copy of the elements in [ lo_, hi_ ], see for_each_in_range ( ).
+    [[nodiscard]] std::vector<ValueType> range ( key_type const & lo_, key_type const & hi_ ) const {
+        std::vector<ValueType> r;
+        for_each_in_range ( lo_, hi_, [ &r ] ( ValueType const & v_ ) { r.push_back ( v_ ); } );
+        return r;
+    }
+
+    // The number of elements ordered after k_ (greater, by std::less), before
+    // k_, and in [ lo_, hi_ ], see tri::count_greater ( ).
+    [[nodiscard]] size_type count_greater ( key_type const & k_ ) const {
+        return tri::count_greater<Compare> ( const_layout{ *this }, end_span, length ( ), k_ );
+    }
+    [[nodiscard]] size_type count_less ( key_type const & k_ ) const {
+        return tri::count_less<Compare> ( const_layout{ *this }, end_span, length ( ), k_ );
+    }
+    [[nodiscard]] size_type count_between ( key_type const & lo_, key_type const & hi_ ) const {
+        return tri::count_between<Compare> ( const_layout{ *this }, end_span, length ( ), lo_, hi_ );
+    }
+
+    // The index of the least element not ordered before k_ (by Compare, the
+    // smallest element >= k_, by std::less), of the least element ordered
+    // after k_ (> k_), and of the greatest element not ordered after k_ (<=
+    // k_), or length ( ) if there is none, see tri::lower_bound ( ).
+    [[nodiscard]] size_type lower_bound ( key_type const & k_ ) const {
+        return tri::lower_bound<Compare> ( const_layout{ *this }, end_span, length ( ), k_ );
+    }
+    [[nodiscard]] size_type upper_bound ( key_type const & k_ ) const {
+        return tri::upper_bound<Compare> ( const_layout{ *this }, end_span, length ( ), k_ );
+    }
+    [[nodiscard]] size_type floor ( key_type const & k_ ) const {
+        return tri::floor<Compare> ( const_layout{ *this }, end_span, length ( ), k_ );
+    }
+
+    // The index of the element closest to k_, or length ( ) if empty, see tri::nearest ( ).
+    [[nodiscard]] size_type nearest ( key_type const & k_ ) const {
+        return tri::nearest<Compare> ( const_layout{ *this }, end_span, length ( ), k_ );
+    }
+
+    // The number of elements with key k_, and their indices (in no particular
+    // order), see tri::equal_range ( ).
+    [[nodiscard]] size_type count ( key_type const & k_ ) const { return count_between ( k_, k_ ); }
+    [[nodiscard]] std::vector<size_type> equal_range ( key_type const & k_ ) const {
+        return tri::equal_range<Compare> ( const_layout{ *this }, end_span, length ( ), k_ );
+    }
+
+    // The element of rank k_, the k_-th in descending order (by Compare), so
+    // that select ( 0 ) is top ( ), leaving the beap as is, see tri::select ( ).
+    [[nodiscard]] const_reference select ( size_type k_ ) const {
+        return tri::select<Compare> ( const_layout{ *this }, end_span, length ( ), k_ );
+    }
 
     // Sizes.
 
-    [[nodiscard]] BEAP_PURE size_type size ( ) const noexcept { return static_cast<int> ( data.size ( ) ); }
+    [[nodiscard]] BEAP_PURE size_type size ( ) const noexcept { return static_cast<size_type> ( data.size ( ) ); }
     [[nodiscard]] BEAP_PURE size_type length ( ) const noexcept { return size ( ); }
-    [[nodiscard]] BEAP_PURE size_type capacity ( ) const noexcept { return static_cast<int> ( data.capacity ( ) ); }
+    [[nodiscard]] BEAP_PURE size_type capacity ( ) const noexcept { return static_cast<size_type> ( data.capacity ( ) ); }
 
+    // Frees the capacity beyond the last row (beyond the last element, while
+    // erase_impl ( ) empties that row). erase_impl ( ) calls this as the load
+    // drops to 50%, calling it directly shrinks at any load.
     void shrink_to_fit ( ) {
-        if ( BEAP_UNLIKELY ( ( capacity ( ) >> 1 ) == size ( ) ) ) { // iff 100% over-allocated, force shrinking.
-            container_type tmp;
-            tmp.reserve ( end_span.end );
-            data = std::move ( ( tmp = data ) );
+        if constexpr ( std::is_same_v<container_type, std::vector<value_type>> ) {
+            size_type const n = std::max ( size ( ), end_span.end + 1 );
+            if ( capacity ( ) > n ) {
+                container_type tmp;
+                tmp.reserve ( n );
+                tmp.assign ( std::make_move_iterator ( data.begin ( ) ), std::make_move_iterator ( data.end ( ) ) );
+                data = std::move ( tmp );
+            }
+        }
+        else {
+            data.shrink_to_fit ( ); // The other storages shrink without copying the lot.
         }
     }
 
@@ -309,38 +522,79 @@ class beap {
     [[nodiscard]] BEAP_PURE iterator end ( ) noexcept { return data.end ( ); }
     [[nodiscard]] BEAP_PURE const_iterator cend ( ) const noexcept { return data.end ( ); }
 
-    [[nodiscard]] BEAP_PURE iterator rbegin ( ) noexcept { return data.rbegin ( ); }
-    [[nodiscard]] BEAP_PURE const_iterator crbegin ( ) const noexcept { return data.rbegin ( ); }
+    [[nodiscard]] BEAP_PURE reverse_iterator rbegin ( ) noexcept { return data.rbegin ( ); }
+    [[nodiscard]] BEAP_PURE const_reverse_iterator crbegin ( ) const noexcept { return data.rbegin ( ); }
 
-    [[nodiscard]] BEAP_PURE iterator rend ( ) noexcept { return data.rend ( ); }
-    [[nodiscard]] BEAP_PURE const_iterator crend ( ) const noexcept { return data.rend ( ); }
+    [[nodiscard]] BEAP_PURE reverse_iterator rend ( ) noexcept { return data.rend ( ); }
+    [[nodiscard]] BEAP_PURE const_reverse_iterator crend ( ) const noexcept { return data.rend ( ); }
 
     // Beap.
 
-    static inline void make_baep ( ) noexcept {
-        end_span    = span_type::span ( 0 );
-        size_type c = 1;
-        iterator b = data.begin ( ) + 1, e = data.end ( );
-        while ( b != e )
-            emplace_impl ( c++, std::move ( *b ) );
+    // An array sorted in descending order is a beap, so (re-)building by
+    // sorting takes O ( n log n ), instead of the O ( n sqrt n ) of inserting
+    // element by element. Pass std::execution::par to sort in parallel.
+    void make_beap ( ) {
+        make_beap_impl ( [] ( auto b_, auto e_, auto c_ ) { std::sort ( b_, e_, c_ ); } );
+    }
+    template<typename ExecutionPolicy, typename = std::enable_if_t<std::is_execution_policy_v<std::remove_cvref_t<ExecutionPolicy>>>>
+    void make_beap ( ExecutionPolicy && policy_ ) {
+        make_beap_impl ( [ &policy_ ] ( auto b_, auto e_, auto c_ ) { std::sort ( policy_, b_, e_, c_ ); } );
     }
 
-    [[nodiscard]] static inline ValueType pop_beap ( ) noexcept {
-        after_exit_erase_top guard ( this );
-        return data.front ( ).v;
+    template<typename Range>
+    [[nodiscard]] static beap build ( Range const & r_ ) {
+        return beap ( std::begin ( r_ ), std::end ( r_ ) );
+    }
+    template<typename ExecutionPolicy, typename Range>
+    [[nodiscard]] static beap build ( ExecutionPolicy && policy_, Range const & r_ ) {
+        return beap ( std::forward<ExecutionPolicy> ( policy_ ), std::begin ( r_ ), std::end ( r_ ) );
+    }
+
+    [[nodiscard]] ValueType pop_beap ( ) noexcept {
+        after_exit_erase_top guard ( *this );
+        return std::move ( data.front ( ).v );
     }
 
     [[maybe_unused]] size_type push_beap ( value_type const & v_ ) { return insert ( v_ ); }
+    [[maybe_unused]] size_type push_beap ( value_type && v_ ) { return insert ( std::move ( v_ ) ); }
+
+    // Pops the top and pushes v_, with a single bubble_down ( ) (the beap is not
+    // empty). Measured on random ints (ns, 100K / 1M keys): pop_beap ( ) and
+    // push_beap ( ) 3080 / 9780, replace_top ( ) 1800 / 5290.
+    [[nodiscard]] ValueType replace_top ( value_type v_ ) noexcept {
+        assert ( not empty ( ) );
+        ValueType t    = std::move ( data.front ( ).v );
+        data.front ( ) = std::move ( v_ );
+        ( void ) bubble_down ( 0, 0 );
+        return t;
+    }
+    // Pushes v_ and pops the top, v_ itself if it would become the top, which
+    // leaves the beap as it is.
+    [[nodiscard]] ValueType pushpop ( value_type v_ ) noexcept {
+        if ( empty ( ) or not( v_ < data.front ( ) ) )
+            return std::move ( v_.v );
+        return replace_top ( std::move ( v_ ) );
+    }
 
     [[nodiscard]] BEAP_PURE reference top ( ) noexcept { return data.front ( ); }
     [[nodiscard]] BEAP_PURE const_reference top ( ) const noexcept { return data.front ( ); }
 
     [[nodiscard]] BEAP_PURE const_reference bottom ( ) const noexcept {
-        for ( size_type min = end_span.beg, i = min + 1, data_end = size ( ); BEAP_LIKELY ( i < data_end ); ++i )
-            if ( BEAP_UNPREDICTABLE ( data[ i ] < data[ min ] ) )
-                min = i;
+        return data[ tri::bottom ( [ this ] ( size_type i_, size_type j_ ) noexcept { return data[ i_ ] < data[ j_ ]; }, end_span, size ( ) ) ];
+    }
+    [[nodiscard]] BEAP_PURE reference bottom ( ) noexcept { return const_cast<reference> ( std::as_const ( *this ).bottom ( ) ); }
+
+    // The element at index i_, as returned by find ( ), lower_bound ( ) and
+    // the like, in O ( 1 ) on every storage (unlike stepping an iterator).
+    [[nodiscard]] BEAP_PURE const_reference operator[] ( size_type i_ ) const noexcept {
+        assert ( 0 <= i_ and i_ < length ( ) );
+        return data[ i_ ];
+    }
+    [[nodiscard]] const_reference at ( size_type i_ ) const {
+        if ( BEAP_UNLIKELY ( i_ < 0 or i_ >= length ( ) ) )
+            throw std::out_of_range ( "beap::at: index out of range" );
+        return data[ i_ ];
     }
-    [[nodiscard]] BEAP_PURE reference bottom ( ) noexcept { return const_cast<reference> ( std::as_const ( this )->bottom ( ) ); }
 
     template<typename ForwardIt>
     [[nodiscard]] static ForwardIt is_beap_untill ( ForwardIt b_, ForwardIt e_ ) noexcept {
@@ -355,22 +609,11 @@ class beap {
         //                11, 12, 14, 17,  9, 13,
         //               3,  2, 10
 
-        size_type size = static_cast<size_type> ( std::distance ( b_, e_ ) );
-        // Searches for out-of-order element, top-down and breadth-first.
-        for ( size_type base_l = 0, base_i = tri::nth_triangular ( base_l ); BEAP_UNLIKELY ( base_i < size );
-              base_l += 1, base_i += base_l + 1 ) {
-            for ( size_type lev = base_l + 1, l_p = base_i - lev + 1, l_i = l_p + ( lev ) + 1, r_p = base_i,
-                            r_i = r_p + ( lev + 2 ) - 2;
-                  BEAP_UNLIKELY ( l_i < size and r_i < size ); lev += 1, l_i += ( lev + 1 ), r_i += ( ( lev + 2 ) - 2 ) ) {
-                if ( not BEAP_UNLIKELY ( Compare ( ) ( data[ l_i ], data[ l_p ] ) ) )
-                    return b_ + l_i;
-                if ( not BEAP_UNLIKELY ( Compare ( ) ( data[ r_i ], data[ r_p ] ) ) )
-                    return b_ + r_i;
-                l_p = l_i;
-                r_p = r_i;
-            }
-        }
-        return e_;
+        return b_ + tri::is_beap_untill (
+                        [ data ] ( size_type i_, size_type j_ ) noexcept {
+                            return tri::less_than<Compare> ( std::invoke ( Projection ( ), data[ i_ ] ), std::invoke ( Projection ( ), data[ j_ ] ) );
+                        },
+                        static_cast<size_type> ( std::distance ( b_, e_ ) ) );
     }
 
     template<typename ForwardIt>
@@ -379,32 +622,28 @@ class beap {
     }
 
     [[nodiscard]] size_type is_beap_untill ( ) noexcept {
-        // Searches for out-of-order element, top-down and breadth-first.
-        size_type siz = size ( );
-        for ( size_type base_l = 0, base_i = tri::nth_triangular ( base_l ); BEAP_UNLIKELY ( base_i < siz );
-              base_l += 1, base_i += base_l + 1 ) {
-            for ( size_type lev = base_l + 1, l_p = base_i - lev + 1, l_i = l_p + ( lev ) + 1, r_p = base_i,
-                            r_i = r_p + ( lev + 2 ) - 2;
-                  BEAP_UNLIKELY ( l_i < siz and r_i < siz ); lev += 1, l_i += ( lev + 1 ), r_i += ( ( lev + 2 ) - 2 ) ) {
-                if ( not BEAP_UNLIKELY ( data[ l_i ] < data[ l_p ] ) )
-                    return l_i;
-                if ( not BEAP_UNLIKELY ( data[ r_i ] < data[ r_p ] ) )
-                    return r_i;
-                l_p = l_i;
-                r_p = r_i;
-            }
-        }
-        return siz;
+        return tri::is_beap_untill ( [ this ] ( size_type i_, size_type j_ ) noexcept { return data[ i_ ] < data[ j_ ]; }, size ( ) );
     }
 
     // Miscelanious.
 
-    void clear ( ) noexcept { data.clear ( ); }
+    void clear ( ) noexcept {
+        data.clear ( );
+        end_span = { 0, -1 };
+    }
     [[nodiscard]] constexpr size_type max_size ( ) const noexcept { return std::numeric_limits<size_type>::max ( ); }
 
-    void swap ( beap & rhs_ ) noexcept { std::swap ( data, rhs_.data ); }
+    // The tracker, told of every move, see detail/policies.hpp.
+    [[nodiscard]] Tracker & tracker ( ) noexcept { return track; }
+    [[nodiscard]] Tracker const & tracker ( ) const noexcept { return track; }
 
-    [[nodiscard]] bool contains ( ValueType const & v_ ) const noexcept { return search ( v_ ).beg; }
+    void swap ( beap & rhs_ ) noexcept {
+        std::swap ( data, rhs_.data );
+        std::swap ( end_span, rhs_.end_span );
+        std::swap ( track, rhs_.track );
+    }
+
+    [[nodiscard]] bool contains ( key_type const & k_ ) const noexcept { return find ( k_ ) != length ( ); }
 
     [[nodiscard]] bool empty ( ) const noexcept { return data.empty ( ); }
 
@@ -419,13 +658,26 @@ class beap {
     // Miscelanious.
 
     private:
-    [[nodiscard]] BEAP_PURE const_reference refof ( size_type i_ ) const noexcept { return ( data.data ( ) )[ i_ ]; }
-    [[nodiscard]] BEAP_PURE reference refof ( size_type i_ ) noexcept { return ( data.data ( ) )[ i_ ]; }
+    [[nodiscard]] BEAP_PURE const_reference refof ( size_type i_ ) const noexcept { return data[ i_ ]; }
+    [[nodiscard]] BEAP_PURE reference refof ( size_type i_ ) noexcept { return data[ i_ ]; }
+    // As above, s_ being the span of the row holding i_.
+    [[nodiscard]] BEAP_PURE const_reference refof ( size_type i_, span_type const & s_ ) const noexcept {
+        return tri::row_at ( data, i_, s_ );
+    }
+    [[nodiscard]] BEAP_PURE reference refof ( size_type i_, span_type const & s_ ) noexcept { return tri::row_at ( data, i_, s_ ); }
+
+    // Tells the tracker element i_ (in the row of span s_) moved there.
+    static constexpr bool tracked = not std::is_same_v<Tracker, tri::untracked>;
+
+    void placed ( size_type i_, span_type const & s_ ) noexcept {
+        if constexpr ( tracked )
+            track ( refof ( i_, s_ ).v, i_ );
+    }
 
     struct after_exit_erase_top {
         beap * c;
         after_exit_erase_top ( beap & c_ ) noexcept : c ( std::addressof ( c_ ) ) {}
-        ~after_exit_erase_top ( ) noexcept { c->erase_impl ( 0, 1 ); };
+        ~after_exit_erase_top ( ) noexcept { c->erase_impl ( 0, 0 ); };
     };
 
     struct after_exit_pop_back {
@@ -434,15 +686,35 @@ class beap {
         ~after_exit_pop_back ( ) noexcept { c->pop_back ( ); }
     };
 
+    template<typename Sort>
+    void make_beap_impl ( Sort sort_ ) {
+        auto descending = [] ( value_type const & a_, value_type const & b_ ) noexcept { return tri::less_than<Compare> ( b_.key ( ), a_.key ( ) ); };
+        if constexpr ( std::random_access_iterator<iterator> ) {
+            sort_ ( data.begin ( ), data.end ( ), descending );
+        }
+        else { // Sort a flat copy, then lay it out row by row.
+            std::vector<value_type> tmp ( std::make_move_iterator ( data.begin ( ) ), std::make_move_iterator ( data.end ( ) ) );
+            sort_ ( tmp.begin ( ), tmp.end ( ), descending );
+            data.clear ( );
+            for ( value_type & v : tmp )
+                data.emplace_back ( std::move ( v ) );
+        }
+        end_span = span_type::span ( tri::nth_triangular_root ( size ( ) ) - 1 );
+        if constexpr ( tracked )
+            for ( size_type i = 0, n = size ( ); i < n; ++i )
+                track ( data[ i ].v, i );
+    }
+
     [[nodiscard]] value_type pop_data ( ) noexcept {
         after_exit_pop_back guard ( data );
-        return data.back ( );
+        return std::move ( data.back ( ) );
     }
 
     // Members.
 
     container_type data;
-    span_type end_span = { 0, 0 };
+    span_type end_span = { 0, -1 };
+    [[no_unique_address]] Tracker track;
 };
 
 #undef PRIVATE
@@ -452,5 +724,6 @@ class beap {
 #undef BEAP_UNPREDICTABLE
 #undef BEAP_LIKELY
 #undef BEAP_UNLIKELY
+#undef BEAP_PREFETCH
 
 #undef ever
@@ -0,0 +1,111 @@
+
+// MIT License
+//
+// Copyright (c) 2020 degski
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+
+#include <bit>
+#include <memory>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace tri {
+
+// A pool of objects that never move, addressed by their slot. The objects
+// live in blocks of BlockSize, allocated on demand and never copied, so that
+// references to them stay valid, the slots of erased objects are reused.
+template<typename T, typename Slot = std::uint32_t, std::size_t BlockSize = 1'024>
+class object_pool {
+
+    static_assert ( std::has_single_bit ( BlockSize ), "the block size is a power of 2" );
+
+    static constexpr int shift = std::countr_zero ( BlockSize );
+
+    using block_type = std::unique_ptr<std::optional<T>[]>;
+
+    public:
+    using slot_type = Slot;
+
+    object_pool ( ) noexcept                = default;
+    object_pool ( object_pool const & )     = delete;
+    object_pool ( object_pool && ) noexcept = default;
+
+    object_pool & operator= ( object_pool const & ) = delete;
+    object_pool & operator= ( object_pool && ) noexcept = default;
+
+    // Constructs the object in place, from args_, and returns its slot.
+    template<typename... Args>
+    [[nodiscard]] slot_type emplace ( Args &&... args_ ) {
+        if ( free_slots.empty ( ) ) {
+            if ( not( end & ( BlockSize - 1 ) ) ) {
+                blocks.emplace_back ( std::make_unique<std::optional<T>[]> ( BlockSize ) );
+                free_slots.reserve ( blocks.size ( ) * BlockSize ); // So that erase ( ) does not allocate.
+            }
+            at ( static_cast<slot_type> ( end ) ).emplace ( std::forward<Args> ( args_ )... );
+            ++live;
+            return static_cast<slot_type> ( end++ );
+        }
+        slot_type const s = free_slots.back ( );
+        at ( s ).emplace ( std::forward<Args> ( args_ )... );
+        free_slots.pop_back ( );
+        ++live;
+        return s;
+    }
+
+    void erase ( slot_type s_ ) noexcept {
+        assert ( at ( s_ ).has_value ( ) );
+        at ( s_ ).reset ( );
+        free_slots.push_back ( s_ );
+        --live;
+    }
+
+    [[nodiscard]] T & operator[] ( slot_type s_ ) noexcept { return *at ( s_ ); }
+    [[nodiscard]] T const & operator[] ( slot_type s_ ) const noexcept { return *at ( s_ ); }
+
+    // The number of slots handed out, live and free.
+    [[nodiscard]] std::size_t slots ( ) const noexcept { return end; }
+    [[nodiscard]] std::size_t size ( ) const noexcept { return live; }
+    [[nodiscard]] bool empty ( ) const noexcept { return not live; }
+
+    void clear ( ) noexcept {
+        blocks.clear ( );
+        free_slots.clear ( );
+        end = 0, live = 0;
+    }
+
+    private:
+    [[nodiscard]] std::optional<T> & at ( slot_type s_ ) noexcept { return blocks[ s_ >> shift ][ s_ & ( BlockSize - 1 ) ]; }
+    [[nodiscard]] std::optional<T> const & at ( slot_type s_ ) const noexcept {
+        return blocks[ s_ >> shift ][ s_ & ( BlockSize - 1 ) ];
+    }
+
+    std::vector<block_type> blocks;
+    std::vector<slot_type> free_slots;
+    std::size_t end = 0, live = 0;
+};
+
+} // namespace tri
@@ -0,0 +1,47 @@
+// MIT License
+//
+// Copyright (c) 2020 degski
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+namespace tri {
+
+// Element policies, how a beap sees the elements it holds (as opposed to the
+// search and storage policies, how it walks and lays them out).
+
+// A projection onto the data member M, f.e. tri::member<&job::deadline>.
+template<auto M>
+struct member {
+    template<typename T>
+    [[nodiscard]] constexpr auto const & operator( ) ( T const & t_ ) const noexcept {
+        return t_.*M;
+    }
+};
+
+// Trackers. A beap calls its tracker with every element (its value) it
+// moves and the index it moved it to, that way the positions of the elements
+// can be kept (see indirect_beap.hpp). The default, untracked, is a no-op.
+struct untracked {
+    template<typename T, typename SizeType>
+    constexpr void operator( ) ( T const &, SizeType ) const noexcept {}
+};
+
+} // namespace tri
@@ -0,0 +1,98 @@
+// MIT License
+//
+// Copyright (c) 2020 degski
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <compare>
+#include <functional>
+#include <limits>
+#include <type_traits>
+
+namespace tri {
+
+// Search policies, they select the kernel of the staircase walk of search ( ).
+//
+// branchy_search switches on the three-way comparison, with the boundary
+// checks as (likely / unlikely) branches, for arithmetic keys on flat storage
+// runs along a row are vectorized (see simd_search.hpp). branchless_search
+// selects the next index, row and height from both comparisons with
+// conditional moves, the branches left (the exit of the walk and the moves
+// along the border of the triangle) are rarely taken. That trades mispredicted
+// branches for a longer dependency chain per step, it requires trivially
+// copyable keys.
+
+struct branchy_search {};
+struct branchless_search {};
+
+// +1 for a max-beap (std::less), -1 for a min-beap (std::greater), 0 for any other comparator.
+template<typename T, typename Compare>
+inline constexpr int order_v = 0;
+template<typename T>
+inline constexpr int order_v<T, std::less<T>> = +1;
+template<typename T>
+inline constexpr int order_v<T, std::less<>> = +1;
+template<typename T>
+inline constexpr int order_v<T, std::greater<T>> = -1;
+template<typename T>
+inline constexpr int order_v<T, std::greater<>> = -1;
+template<typename T>
+inline constexpr int order_v<T, std::compare_three_way> = +1;
+
+// Comparators are either less-than, or three-way (returning a std::weak_ordering
+// or std::strong_ordering, like std::compare_three_way). The latter give the
+// three-way comparison of the staircase walk from a single call.
+template<typename Compare, typename T>
+inline constexpr bool is_three_way_v = std::is_convertible_v<std::invoke_result_t<Compare, T const &, T const &>, std::weak_ordering>;
+
+template<typename Compare, typename T>
+[[nodiscard]] constexpr bool less_than ( T const & a_, T const & b_ ) noexcept {
+    if constexpr ( is_three_way_v<Compare, T> )
+        return Compare ( ) ( a_, b_ ) < 0;
+    else
+        return Compare ( ) ( a_, b_ );
+}
+
+// -1, 0 or +1 as a_ is less than, equivalent to, or greater than b_.
+template<typename Compare, typename T>
+[[nodiscard]] constexpr int three_way ( T const & a_, T const & b_ ) noexcept {
+    if constexpr ( is_three_way_v<Compare, T> ) {
+        auto const o = Compare ( ) ( a_, b_ );
+        return static_cast<int> ( o > 0 ) - static_cast<int> ( o < 0 );
+    }
+    else {
+        return static_cast<int> ( Compare ( ) ( b_, a_ ) ) - static_cast<int> ( Compare ( ) ( a_, b_ ) );
+    }
+}
+
+// The arithmetic value ordered (by Compare) before all others.
+template<typename T, typename Compare>
+[[nodiscard]] constexpr T lowest ( ) noexcept {
+    static_assert ( std::is_arithmetic_v<T> and order_v<T, Compare> != 0,
+                    "the lowest value is known for arithmetic types ordered by std::less or std::greater" );
+    using limits = std::numeric_limits<T>;
+    if constexpr ( limits::has_infinity )
+        return order_v<T, Compare> > 0 ? -limits::infinity ( ) : limits::infinity ( );
+    else
+        return order_v<T, Compare> > 0 ? limits::lowest ( ) : limits::max ( );
+}
+
+} // namespace tri
@@ -0,0 +1,214 @@
+// MIT License
+//
+// Copyright (c) 2020 degski
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <bit>
+#include <functional>
+#include <type_traits>
+
+#if defined( __AVX2__ )
+#    include <immintrin.h>
+#endif
+
+#include "search.hpp"
+
+namespace tri::simd {
+
+// A vectorized scan for the staircase walk of search ( ), for arithmetic
+// keys, ordered by std::less or std::greater, over a flat (contiguous) beap.
+// The walk often alternates between a step down-right (i += h + 2, the key
+// is below the element) and a step up (i -= h + 1, the key is above the
+// element), which nets i += 1, i.e. it moves along row h while the key is
+// below the elements of row h and above those of row h + 1 (one further on),
+// both contiguous. A vector of each row gives, from two compares, a mask of
+// which the trailing ones are the pairs of steps taken, lanes pairs (twice
+// as many steps) per iteration.
+//
+// Selected at compile time, AVX-512F/VL (16 32-bit, 8 64-bit lanes) over AVX2
+// (8 or 4 lanes). Without either (or for other types and comparators) the
+// scalar search is all there is.
+
+#if defined( __AVX2__ )
+
+template<typename T>
+inline constexpr bool is_key_v = std::is_same_v<T, std::int32_t> or std::is_same_v<T, std::int64_t> or std::is_same_v<T, float> or
+                                 std::is_same_v<T, double>;
+
+using tri::order_v;
+
+template<typename T, typename Compare>
+inline constexpr bool enabled_v = is_key_v<T> and order_v<T, Compare> != 0;
+
+// The per type (and instruction set) operations, an unaligned load and the
+// bit mask of the lanes where a_ > b_.
+
+#    if defined( __AVX512F__ ) && defined( __AVX512VL__ )
+
+template<typename T, std::size_t Size = sizeof ( T )>
+struct ops;
+
+template<typename T>
+struct ops<T, 4> {
+    static constexpr int lanes = 16;
+
+    [[nodiscard]] static auto load ( T const * p_ ) noexcept {
+        if constexpr ( std::is_integral_v<T> )
+            return _mm512_loadu_si512 ( p_ );
+        else
+            return _mm512_loadu_ps ( p_ );
+    }
+    [[nodiscard]] static auto set1 ( T v_ ) noexcept {
+        if constexpr ( std::is_integral_v<T> )
+            return _mm512_set1_epi32 ( v_ );
+        else
+            return _mm512_set1_ps ( v_ );
+    }
+    [[nodiscard]] static unsigned greater ( auto const & a_, auto const & b_ ) noexcept {
+        if constexpr ( std::is_integral_v<T> )
+            return _mm512_cmpgt_epi32_mask ( a_, b_ );
+        else
+            return _mm512_cmp_ps_mask ( a_, b_, _CMP_GT_OQ );
+    }
+};
+
+template<typename T>
+struct ops<T, 8> {
+    static constexpr int lanes = 8;
+
+    [[nodiscard]] static auto load ( T const * p_ ) noexcept {
+        if constexpr ( std::is_integral_v<T> )
+            return _mm512_loadu_si512 ( p_ );
+        else
+            return _mm512_loadu_pd ( p_ );
+    }
+    [[nodiscard]] static auto set1 ( T v_ ) noexcept {
+        if constexpr ( std::is_integral_v<T> )
+            return _mm512_set1_epi64 ( v_ );
+        else
+            return _mm512_set1_pd ( v_ );
+    }
+    [[nodiscard]] static unsigned greater ( auto const & a_, auto const & b_ ) noexcept {
+        if constexpr ( std::is_integral_v<T> )
+            return _mm512_cmpgt_epi64_mask ( a_, b_ );
+        else
+            return _mm512_cmp_pd_mask ( a_, b_, _CMP_GT_OQ );
+    }
+};
+
+#    else // AVX2
+
+template<typename T, std::size_t Size = sizeof ( T )>
+struct ops;
+
+template<typename T>
+struct ops<T, 4> {
+    static constexpr int lanes = 8;
+
+    [[nodiscard]] static auto load ( T const * p_ ) noexcept {
+        if constexpr ( std::is_integral_v<T> )
+            return _mm256_loadu_si256 ( reinterpret_cast<__m256i const *> ( p_ ) );
+        else
+            return _mm256_loadu_ps ( p_ );
+    }
+    [[nodiscard]] static auto set1 ( T v_ ) noexcept {
+        if constexpr ( std::is_integral_v<T> )
+            return _mm256_set1_epi32 ( v_ );
+        else
+            return _mm256_set1_ps ( v_ );
+    }
+    [[nodiscard]] static unsigned greater ( auto const & a_, auto const & b_ ) noexcept {
+        if constexpr ( std::is_integral_v<T> )
+            return static_cast<unsigned> ( _mm256_movemask_ps ( _mm256_castsi256_ps ( _mm256_cmpgt_epi32 ( a_, b_ ) ) ) );
+        else
+            return static_cast<unsigned> ( _mm256_movemask_ps ( _mm256_cmp_ps ( a_, b_, _CMP_GT_OQ ) ) );
+    }
+};
+
+template<typename T>
+struct ops<T, 8> {
+    static constexpr int lanes = 4;
+
+    [[nodiscard]] static auto load ( T const * p_ ) noexcept {
+        if constexpr ( std::is_integral_v<T> )
+            return _mm256_loadu_si256 ( reinterpret_cast<__m256i const *> ( p_ ) );
+        else
+            return _mm256_loadu_pd ( p_ );
+    }
+    [[nodiscard]] static auto set1 ( T v_ ) noexcept {
+        if constexpr ( std::is_integral_v<T> )
+            return _mm256_set1_epi64x ( v_ );
+        else
+            return _mm256_set1_pd ( v_ );
+    }
+    [[nodiscard]] static unsigned greater ( auto const & a_, auto const & b_ ) noexcept {
+        if constexpr ( std::is_integral_v<T> )
+            return static_cast<unsigned> ( _mm256_movemask_pd ( _mm256_castsi256_pd ( _mm256_cmpgt_epi64 ( a_, b_ ) ) ) );
+        else
+            return static_cast<unsigned> ( _mm256_movemask_pd ( _mm256_cmp_pd ( a_, b_, _CMP_GT_OQ ) ) );
+    }
+};
+
+#    endif
+
+// Scans row h_ from i_ (row h_ ends at e_) as long as the pairs of steps
+// continue, returns the number of pairs, i.e. how far i_ moves on. Stops
+// short of the bottom, where the vector of row h_ + 1 would be out of bounds.
+template<int Order, typename T, typename SizeType>
+[[nodiscard]] SizeType scan ( T const * data_, SizeType len_, SizeType i_, SizeType h_, SizeType e_, T v_ ) noexcept {
+    using o             = ops<T>;
+    constexpr int lanes = o::lanes;
+    auto const v        = o::set1 ( v_ );
+    SizeType const b    = i_;
+    // Lane t is a pair iff the key is before element t of row h_ and after element t + 1 of row h_ + 1, at the
+    // end of the row there are no more pairs.
+    while ( ( i_ + h_ + 2 + lanes ) <= len_ ) {
+        SizeType const r = e_ - i_;
+        auto const x     = o::load ( data_ + i_ ), y = o::load ( data_ + i_ + h_ + 2 );
+        unsigned const m = ( Order > 0 ? o::greater ( x, v ) & o::greater ( v, y ) : o::greater ( v, x ) & o::greater ( y, v ) ) &
+                           ( r < lanes ? ( 1u << r ) - 1u : ~0u );
+        int const k = std::countr_one ( m );
+        i_ += k;
+        if ( k < lanes )
+            break;
+    }
+    return i_ - b;
+}
+
+#else
+
+template<typename T, typename Compare>
+inline constexpr bool enabled_v = false;
+
+using tri::order_v;
+
+template<int Order, typename T, typename SizeType>
+[[nodiscard]] SizeType scan ( T const *, SizeType, SizeType, SizeType, SizeType, T ) noexcept {
+    return 0;
+}
+
+#endif
+
+} // namespace tri::simd
@@ -0,0 +1,266 @@
+// MIT License
+//
+// Copyright (c) 2020 degski
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+
+#include <algorithm>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <new>
+#include <utility>
+
+#if defined( _WIN32 )
+#    ifndef NOMINMAX
+#        define NOMINMAX
+#    endif
+#    ifndef WIN32_LEAN_AND_MEAN
+#        define WIN32_LEAN_AND_MEAN
+#    endif
+#    include <windows.h>
+#else
+#    include <sys/mman.h>
+#endif
+
+#include "triangular.hpp"
+
+namespace tri {
+
+namespace vm {
+
+// Commits (and releases) happen in multiples of a (x64) huge page.
+inline constexpr std::size_t granularity = std::size_t{ 1 } << 21;
+
+[[nodiscard]] inline void * reserve ( std::size_t bytes_ ) {
+#if defined( _WIN32 )
+    void * p = VirtualAlloc ( nullptr, bytes_, MEM_RESERVE, PAGE_NOACCESS );
+    if ( BEAP_UNLIKELY ( not p ) )
+        throw std::bad_alloc ( );
+#else
+    void * p = mmap ( nullptr, bytes_, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0 );
+    if ( BEAP_UNLIKELY ( p == MAP_FAILED ) )
+        throw std::bad_alloc ( );
+#    if defined( MADV_HUGEPAGE )
+    madvise ( p, bytes_, MADV_HUGEPAGE ); // Transparent huge pages, a hint, failure is not an error.
+#    endif
+#endif
+    return p;
+}
+
+inline void release ( void * p_, std::size_t bytes_ ) noexcept {
+#if defined( _WIN32 )
+    ( void ) bytes_;
+    VirtualFree ( p_, 0, MEM_RELEASE );
+#else
+    munmap ( p_, bytes_ );
+#endif
+}
+
+inline void commit ( void * p_, std::size_t bytes_ ) {
+#if defined( _WIN32 )
+    if ( BEAP_UNLIKELY ( not VirtualAlloc ( p_, bytes_, MEM_COMMIT, PAGE_READWRITE ) ) )
+        throw std::bad_alloc ( );
+#else
+    if ( BEAP_UNLIKELY ( mprotect ( p_, bytes_, PROT_READ | PROT_WRITE ) ) )
+        throw std::bad_alloc ( );
+#endif
+}
+
+// Hands the pages back to the os, the address range stays reserved.
+inline void decommit ( void * p_, std::size_t bytes_ ) noexcept {
+#if defined( _WIN32 )
+    VirtualFree ( p_, bytes_, MEM_DECOMMIT );
+#else
+    madvise ( p_, bytes_, MADV_DONTNEED );
+    mprotect ( p_, bytes_, PROT_NONE );
+#endif
+}
+
+} // namespace vm
+
+// Virtual memory layout. Address space for all elements a beap can hold
+// (bounded by the size type, and by a budget of 512MB on 32-bit systems and
+// of 1TB on 64-bit ones) is reserved up front and committed in 2MB steps as
+// the beap grows. As the elements never move, growing does not copy anything
+// and shrink_to_fit (or popping more than ReleaseSlack bytes below the
+// committed top) returns whole pages to the os. The layout is the flat one
+// of std::vector.
+template<typename T, typename SizeType, std::size_t ReleaseSlack>
+class virtual_storage {
+
+    public:
+    using value_type             = T;
+    using size_type              = SizeType;
+    using difference_type        = std::ptrdiff_t;
+    using reference              = T &;
+    using const_reference        = T const &;
+    using pointer                = T *;
+    using const_pointer          = T const *;
+    using iterator               = T *;
+    using const_iterator         = T const *;
+    using reverse_iterator       = std::reverse_iterator<iterator>;
+    using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+    private:
+    using span_type = basic_span_type<size_type>;
+
+    // The elements are counted before they are multiplied by their size, so
+    // that a 64-bit size type cannot overflow the byte count.
+    static constexpr std::size_t reserved_bytes = [] ( ) {
+        std::size_t const budget = sizeof ( void * ) < 8 ? std::size_t{ 1 } << 29 : std::size_t{ 1 } << 40;
+        std::size_t const n = std::min ( static_cast<std::size_t> ( std::numeric_limits<size_type>::max ( ) ), budget / sizeof ( T ) );
+        return ( n * sizeof ( T ) + vm::granularity - 1 ) & ~( vm::granularity - 1 );
+    }( );
+
+    public:
+    virtual_storage ( ) noexcept = default;
+    virtual_storage ( virtual_storage const & v_ ) {
+        reserve ( v_.len );
+        std::uninitialized_copy ( v_.begin ( ), v_.end ( ), base );
+        len = v_.len;
+    }
+    virtual_storage ( virtual_storage && v_ ) noexcept :
+        base ( std::exchange ( v_.base, nullptr ) ), len ( std::exchange ( v_.len, 0 ) ),
+        committed ( std::exchange ( v_.committed, 0 ) ) {}
+
+    template<typename ForwardIt>
+    virtual_storage ( ForwardIt b_, ForwardIt e_ ) {
+        reserve ( static_cast<size_type> ( std::distance ( b_, e_ ) ) );
+        for ( ; b_ != e_; ++b_ )
+            emplace_back ( *b_ );
+    }
+
+    ~virtual_storage ( ) noexcept {
+        if ( base ) {
+            clear ( );
+            vm::release ( base, reserved_bytes );
+        }
+    }
+
+    [[maybe_unused]] virtual_storage & operator= ( virtual_storage const & v_ ) {
+        if ( this != std::addressof ( v_ ) ) {
+            clear ( );
+            reserve ( v_.len );
+            std::uninitialized_copy ( v_.begin ( ), v_.end ( ), base );
+            len = v_.len;
+        }
+        return *this;
+    }
+    [[maybe_unused]] virtual_storage & operator= ( virtual_storage && v_ ) noexcept {
+        std::swap ( base, v_.base );
+        std::swap ( len, v_.len );
+        std::swap ( committed, v_.committed );
+        return *this;
+    }
+
+    [[nodiscard]] BEAP_PURE reference row_at ( size_type i_, span_type const & ) noexcept { return base[ i_ ]; }
+    [[nodiscard]] BEAP_PURE const_reference row_at ( size_type i_, span_type const & ) const noexcept { return base[ i_ ]; }
+
+    [[nodiscard]] reference operator[] ( size_type i_ ) noexcept { return base[ i_ ]; }
+    [[nodiscard]] const_reference operator[] ( size_type i_ ) const noexcept { return base[ i_ ]; }
+
+    [[nodiscard]] pointer data ( ) noexcept { return base; }
+    [[nodiscard]] const_pointer data ( ) const noexcept { return base; }
+
+    [[nodiscard]] reference front ( ) noexcept { return base[ 0 ]; }
+    [[nodiscard]] const_reference front ( ) const noexcept { return base[ 0 ]; }
+    [[nodiscard]] reference back ( ) noexcept { return base[ len - 1 ]; }
+    [[nodiscard]] const_reference back ( ) const noexcept { return base[ len - 1 ]; }
+
+    template<typename... Args>
+    [[maybe_unused]] reference emplace_back ( Args &&... args_ ) {
+        if ( BEAP_UNLIKELY ( static_cast<std::size_t> ( len + 1 ) * sizeof ( T ) > committed ) )
+            reserve ( len + 1 );
+        return *::new ( static_cast<void *> ( base + len++ ) ) T ( std::forward<Args> ( args_ )... );
+    }
+    void push_back ( T const & v_ ) { emplace_back ( v_ ); }
+
+    void pop_back ( ) noexcept {
+        std::destroy_at ( base + --len );
+        if ( BEAP_UNLIKELY ( committed - in_use ( ) > ReleaseSlack ) )
+            shrink_to_fit ( );
+    }
+
+    void reserve ( size_type n_ ) {
+        if ( BEAP_UNLIKELY ( static_cast<std::size_t> ( n_ ) > reserved_bytes / sizeof ( T ) ) )
+            throw std::bad_alloc ( );
+        std::size_t bytes = round_up ( static_cast<std::size_t> ( n_ ) * sizeof ( T ) );
+        if ( BEAP_UNLIKELY ( not base ) ) // The address space is reserved on first use (and after a move).
+            base = static_cast<T *> ( vm::reserve ( reserved_bytes ) );
+        if ( bytes > committed ) {
+            vm::commit ( reinterpret_cast<char *> ( base ) + committed, bytes - committed );
+            committed = bytes;
+        }
+    }
+
+    void clear ( ) noexcept {
+        std::destroy ( base, base + len );
+        len = 0;
+    }
+
+    void shrink_to_fit ( ) noexcept {
+        if ( std::size_t bytes = in_use ( ); bytes < committed ) {
+            vm::decommit ( reinterpret_cast<char *> ( base ) + bytes, committed - bytes );
+            committed = bytes;
+        }
+    }
+
+    [[nodiscard]] size_type size ( ) const noexcept { return len; }
+    [[nodiscard]] bool empty ( ) const noexcept { return not len; }
+    [[nodiscard]] size_type capacity ( ) const noexcept { return static_cast<size_type> ( committed / sizeof ( T ) ); }
+
+    [[nodiscard]] iterator begin ( ) noexcept { return base; }
+    [[nodiscard]] const_iterator begin ( ) const noexcept { return base; }
+    [[nodiscard]] const_iterator cbegin ( ) const noexcept { return base; }
+    [[nodiscard]] iterator end ( ) noexcept { return base + len; }
+    [[nodiscard]] const_iterator end ( ) const noexcept { return base + len; }
+    [[nodiscard]] const_iterator cend ( ) const noexcept { return base + len; }
+
+    [[nodiscard]] reverse_iterator rbegin ( ) noexcept { return reverse_iterator{ end ( ) }; }
+    [[nodiscard]] const_reverse_iterator rbegin ( ) const noexcept { return const_reverse_iterator{ end ( ) }; }
+    [[nodiscard]] reverse_iterator rend ( ) noexcept { return reverse_iterator{ begin ( ) }; }
+    [[nodiscard]] const_reverse_iterator rend ( ) const noexcept { return const_reverse_iterator{ begin ( ) }; }
+
+    private:
+    [[nodiscard]] static constexpr std::size_t round_up ( std::size_t bytes_ ) noexcept {
+        return ( bytes_ + vm::granularity - 1 ) & ~( vm::granularity - 1 );
+    }
+    // Committed bytes needed to hold the current elements.
+    [[nodiscard]] std::size_t in_use ( ) const noexcept { return round_up ( static_cast<std::size_t> ( len ) * sizeof ( T ) ); }
+
+    T * base              = nullptr;
+    size_type len         = 0;
+    std::size_t committed = 0;
+};
+
+template<std::size_t ReleaseSlack = 4 * vm::granularity>
+struct virtual_memory {
+    template<typename T, typename SizeType>
+    using type = virtual_storage<T, SizeType, ReleaseSlack>;
+};
+
+} // namespace tri
@@ -0,0 +1,656 @@
+// MIT License
+//
+// Copyright (c) 2020 degski
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+
+#include <algorithm>
+#include <bit>
+#include <functional>
+#include <memory>
+#include <numeric>
+#include <span>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "triangular.hpp"
+#include "search.hpp"
+
+// The sifts prefetch the candidates BEAP_SIFT_PREFETCH_DISTANCE rows ahead (0
+// turns that off), in beaps of at least BEAP_SIFT_PREFETCH_MIN_SIZE elements.
+#ifndef BEAP_SIFT_PREFETCH_DISTANCE
+#    define BEAP_SIFT_PREFETCH_DISTANCE 8
+#endif
+#ifndef BEAP_SIFT_PREFETCH_MIN_SIZE
+#    define BEAP_SIFT_PREFETCH_MIN_SIZE 65'536
+#endif
+
+namespace tri {
+
+// The walks over the triangular array, shared by beap and beap_view (over
+// their elements) and keyed_beap (over its keys). Elements are addressed by
+// their index and the span of their row (the storages that are laid out by
+// row use the latter, see storage.hpp). With Padded, the last row is complete,
+// right of the last element are the lowest values (see tri::padded).
+//
+// A Layout l_ gives access to the elements:
+//
+//   l_.at ( i, s )        a reference to element i (of row s),
+//   l_.key ( e )          the key of element e (as compared),
+//   l_.placed ( i, s )    called after every write to element i (by the sifts).
+//
+// The walks that only read take a layout of a const beap, last_ being the span
+// of its last row, len_ its length.
+
+// One step of the staircase walk of a search, c_ ( i, s ) being the three-way
+// comparison of the key searched for with element i (of row s), last_ the span
+// of the last row. Returns true when the walk is done, i_ then holds the index
+// found (or len_ on a miss).
+template<bool Padded, typename SizeType, typename ThreeWay>
+[[nodiscard]] bool search_step ( ThreeWay const & c_, basic_span_type<SizeType> & s_, SizeType & i_, SizeType & h_, SizeType len_,
+                                 basic_span_type<SizeType> const & last_ ) noexcept {
+    switch ( BEAP_UNPREDICTABLE ( c_ ( i_, s_ ) ) ) {
+        case -1: {
+            if constexpr ( Padded ) {
+                if ( BEAP_LIKELY ( s_.end < last_.end ) ) {
+                    ++s_, i_ += h_ + 2, h_ += 1;
+                    return false;
+                }
+                if ( BEAP_UNLIKELY ( i_ == s_.end ) )
+                    break;
+                i_ += 1;
+                return false;
+            }
+            if ( SizeType i = i_ + h_ + 2; BEAP_LIKELY ( i < len_ ) ) {
+                ++s_, i_ = i, h_ += 1;
+                return false;
+            }
+            if ( BEAP_UNLIKELY ( i_ == s_.end ) )
+                break;
+            if ( BEAP_LIKELY ( ( i_ + 1 ) < len_ ) ) {
+                i_ += 1;
+                return false;
+            }
+            if ( BEAP_UNLIKELY ( i_ == ( s_.end - 1 ) ) )
+                break;
+            --s_, i_ -= h_--, i_ += 1;
+            return false;
+        }
+        case +1: {
+            if ( BEAP_UNLIKELY ( i_ == s_.end ) )
+                break;
+            --s_, i_ -= h_--;
+            return false;
+        }
+        default: {
+            if ( not Padded or i_ < len_ )
+                return true;
+        }
+    }
+    i_ = len_;
+    return true;
+}
+
+// The staircase walk of a search, from the start of the last row, last_, down
+// the columns of the matrix view and up its rows. Returns the index found (or
+// len_ on a miss) and its row.
+template<bool Padded, typename SizeType, typename ThreeWay>
+[[nodiscard]] basic_span_type<SizeType> search ( ThreeWay const & c_, basic_span_type<SizeType> const & last_, SizeType len_ ) noexcept {
+    basic_span_type<SizeType> s = last_;
+    SizeType i = s.beg, h = s.end - s.beg;
+    if ( BEAP_UNLIKELY ( not len_ ) )
+        return { len_, h };
+    while ( not search_step<Padded> ( c_, s, i, h, len_, last_ ) )
+        ;
+    return { i, h };
+}
+
+// The walk of search ( ), in which steps down-right followed by steps up
+// hand over to scan_ ( i, h, e ), which scans row h from i to e, returning the
+// number of elements it could skip (see simd_search.hpp). The scan stays
+// within len_, with Padded the steps need not.
+template<bool Padded, typename SizeType, typename ThreeWay, typename Scan>
+[[nodiscard]] basic_span_type<SizeType> search_scanning ( ThreeWay const & c_, Scan const & scan_, basic_span_type<SizeType> const & last_,
+                                                          SizeType len_ ) noexcept {
+    basic_span_type<SizeType> s = last_;
+    SizeType i = s.beg, h = s.end - s.beg;
+    if ( BEAP_UNLIKELY ( not len_ ) )
+        return { len_, h };
+    int pairs = 0; // Of a step right, then up.
+    for ( bool right = false;; ) {
+        SizeType const g = h;
+        if ( search_step<Padded> ( c_, s, i, h, len_, last_ ) )
+            return { i, h };
+        if ( h > g ) {
+            pairs = right ? 0 : pairs, right = true;
+            continue;
+        }
+        pairs = right and h < g ? pairs + 1 : 0, right = false;
+        if ( pairs == 2 ) { // The scan costs about as much as a pair, so only after a second one.
+            i += scan_ ( i, h, s.end );
+            pairs = 0;
+        }
+    }
+}
+
+// The sifts. With ahead_, they prefetch Ahead rows ahead. The element sifted
+// is moved into a hole, which moves the other way, and written once, at the
+// end.
+
+// The candidates a sift reaches k rows on form a run of k + 1 elements of that
+// row, which is about covered by the lines holding its ends, those are what
+// sift_prefetch ( ) is given. Measured on random ints (ns, 1M / 10M / 50M
+// keys), distance 0 against 8: insert 4730 / 21980 / 71500 -> 3880 / 19380 /
+// 60020, pop 12060 / 85800 / 254200 -> 9990 / 76260 / 250460 (32 is no
+// better).
+inline constexpr std::size_t sift_prefetch_distance = BEAP_SIFT_PREFETCH_DISTANCE;
+
+// Whether the sifts over len_ elements prefetch.
+template<typename SizeType>
+[[nodiscard]] constexpr bool sift_prefetches ( SizeType len_ ) noexcept {
+    return sift_prefetch_distance and len_ >= BEAP_SIFT_PREFETCH_MIN_SIZE;
+}
+
+// Prefetches elements b_ and e_ (clamped to the row) of row h_ at beg_.
+template<typename SizeType, typename Layout>
+void sift_prefetch ( Layout const & l_, SizeType beg_, SizeType h_, SizeType b_, SizeType e_ ) noexcept {
+    basic_span_type<SizeType> const r = { beg_, beg_ + h_ };
+    BEAP_PREFETCH ( std::addressof ( l_.at ( beg_ + std::max ( b_, SizeType{ 0 } ), r ) ) );
+    BEAP_PREFETCH ( std::addressof ( l_.at ( beg_ + std::min ( e_, h_ ), r ) ) );
+}
+
+// Sifts element i_ of row h_ up, returns the index it ends up at.
+template<typename Compare, std::size_t Ahead, typename SizeType, typename Layout>
+[[maybe_unused]] SizeType sift_up ( Layout & l_, SizeType i_, SizeType h_, bool ahead_ ) noexcept {
+    SizeType constexpr k = static_cast<SizeType> ( Ahead );
+    using span_type = basic_span_type<SizeType>;
+    span_type s     = span_type::span ( h_ );
+    auto v          = std::move ( l_.at ( i_, s ) ); // Parents move down into the hole, v is written once.
+    while ( BEAP_LIKELY ( h_ ) ) {
+        if ( ahead_ and h_ >= k ) { // The ancestors k rows up are d - k .. d of row h - k.
+            SizeType const d = i_ - s.beg;
+            sift_prefetch ( l_, s.beg - k * h_ + k * ( k - 1 ) / 2, h_ - k, d - k, d );
+        }
+        span_type p = s.prev ( );
+        SizeType d  = i_ - s.beg;
+        SizeType l = -1, r = -1; // Index 0 is a valid parent, -1 flags a missing one.
+        if ( BEAP_UNLIKELY ( i_ != s.beg ) )
+            l = p.beg + d - 1;
+        if ( BEAP_UNLIKELY ( i_ != s.end ) )
+            r = p.beg + d;
+        if ( BEAP_UNPREDICTABLE ( ( l >= 0 ) and less_than<Compare> ( l_.key ( l_.at ( l, p ) ), l_.key ( v ) ) and
+                                  ( r < 0 or less_than<Compare> ( l_.key ( l_.at ( l, p ) ), l_.key ( l_.at ( r, p ) ) ) ) ) ) {
+            l_.at ( i_, s ) = std::move ( l_.at ( l, p ) );
+            l_.placed ( i_, s );
+            i_ = l;
+        }
+        else if ( BEAP_UNPREDICTABLE ( ( r >= 0 ) and less_than<Compare> ( l_.key ( l_.at ( r, p ) ), l_.key ( v ) ) ) ) {
+            l_.at ( i_, s ) = std::move ( l_.at ( r, p ) );
+            l_.placed ( i_, s );
+            i_ = r;
+        }
+        else {
+            break;
+        }
+        s = p;
+        h_ -= 1;
+    }
+    assert ( h_ or i_ == 0 );
+    l_.at ( i_, s ) = std::move ( v );
+    l_.placed ( i_, s );
+    return i_;
+}
+
+// Sifts element i_ of row h_ down, in a beap of len_ elements, of which the
+// last row is h_1_, returns the index it ends up at.
+template<typename Compare, bool Padded, std::size_t Ahead, typename SizeType, typename Layout>
+[[maybe_unused]] SizeType sift_down ( Layout & l_, SizeType i_, SizeType h_, SizeType h_1_, SizeType len_, bool ahead_ ) noexcept {
+    SizeType constexpr k = static_cast<SizeType> ( Ahead );
+    using span_type = basic_span_type<SizeType>;
+    span_type s     = span_type::span ( h_ );
+    auto v          = std::move ( l_.at ( i_, s ) ); // Children move up into the hole, v is written once.
+    while ( BEAP_LIKELY ( h_ < h_1_ ) ) {
+        if ( ahead_ and h_ + k < h_1_ ) { // The descendants k rows down are d .. d + k of row h + k, a complete row.
+            SizeType const d = i_ - s.beg;
+            sift_prefetch ( l_, s.beg + k * h_ + k * ( k + 1 ) / 2, h_ + k, d, d + k );
+        }
+        span_type c = s.next ( );
+        SizeType l = c.beg + i_ - s.beg, r = l + 1;
+        if constexpr ( not Padded ) { // Else both children exist, those beyond the length are the lowest values.
+            if ( BEAP_LIKELY ( l < len_ ) ) {
+                if ( BEAP_UNLIKELY ( r >= len_ ) )
+                    r = 0;
+            }
+            else {
+                l = 0, r = 0;
+            }
+        }
+        if ( BEAP_UNPREDICTABLE ( ( Padded or l ) and less_than<Compare> ( l_.key ( v ), l_.key ( l_.at ( l, c ) ) ) and
+                                  ( ( not Padded and not r ) or less_than<Compare> ( l_.key ( l_.at ( r, c ) ), l_.key ( l_.at ( l, c ) ) ) ) ) ) {
+            l_.at ( i_, s ) = std::move ( l_.at ( l, c ) );
+            l_.placed ( i_, s );
+            i_ = l;
+        }
+        else if ( BEAP_UNPREDICTABLE ( ( Padded or r ) and less_than<Compare> ( l_.key ( v ), l_.key ( l_.at ( r, c ) ) ) ) ) {
+            l_.at ( i_, s ) = std::move ( l_.at ( r, c ) );
+            l_.placed ( i_, s );
+            i_ = r;
+        }
+        else {
+            break;
+        }
+        s = c;
+        h_ += 1;
+    }
+    l_.at ( i_, s ) = std::move ( v );
+    l_.placed ( i_, s );
+    return i_;
+}
+
+// The index of the first element (top-down and breadth-first) that is not
+// ordered before its parents, less_ ( i, j ) comparing elements i and j, or
+// len_ if there is none.
+template<typename SizeType, typename Less>
+[[nodiscard]] SizeType is_beap_untill ( Less const & less_, SizeType len_ ) noexcept {
+    for ( SizeType base_l = 0, base_i = nth_triangular ( base_l ); BEAP_UNLIKELY ( base_i < len_ ); base_l += 1, base_i += base_l + 1 ) {
+        for ( SizeType lev = base_l + 1, l_p = base_i - lev + 1, l_i = l_p + ( lev ) + 1, r_p = base_i, r_i = r_p + ( lev + 2 ) - 2;
+              BEAP_UNLIKELY ( l_i < len_ and r_i < len_ ); lev += 1, l_i += ( lev + 1 ), r_i += ( ( lev + 2 ) - 2 ) ) {
+            if ( not BEAP_UNLIKELY ( less_ ( l_i, l_p ) ) )
+                return l_i;
+            if ( not BEAP_UNLIKELY ( less_ ( r_i, r_p ) ) )
+                return r_i;
+            l_p = l_i;
+            r_p = r_i;
+        }
+    }
+    return len_;
+}
+
+// The index of the bottom (minimal) element, less_ ( i, j ) comparing elements
+// i and j, last_ being the span of the last row (the beap is not empty).
+template<typename SizeType, typename Less>
+[[nodiscard]] SizeType bottom ( Less const & less_, basic_span_type<SizeType> const & last_, SizeType len_ ) noexcept {
+    // The minimum is a leaf, i.e. in the last row or in the childless tail of the row above.
+    SizeType min = std::min ( len_ - ( last_.end - last_.beg ), last_.beg );
+    for ( SizeType i = min + 1; BEAP_LIKELY ( i < len_ ); ++i )
+        if ( BEAP_UNPREDICTABLE ( less_ ( i, min ) ) )
+            min = i;
+    return min;
+}
+
+// The walks of the matrix view, element ( a, b ) of which is element b of row
+// a + b, its children being ( a + 1, b ) and ( a, b + 1 ), so that its rows
+// and its columns are ordered (descending, by Compare), see is_beap_untill ( ).
+template<typename SizeType, typename Layout>
+[[nodiscard]] decltype ( auto ) matrix_at ( Layout const & l_, SizeType a_, SizeType b_ ) noexcept {
+    basic_span_type<SizeType> const s = basic_span_type<SizeType>::span ( a_ + b_ );
+    return l_.at ( s.beg + b_, s );
+}
+
+// In every column b of the matrix view, the elements not ordered before a
+// key form a prefix, the staircase of the key, of which the length does
+// not increase with b. Calls f_ ( b, u, l ) for every column b, u being
+// the length of the staircase of the elements ordered after hi_, l that
+// of the elements not ordered before lo_, so that the elements in [ lo_,
+// hi_ ] are those of [ u, l ). Both walk up the columns only, so this
+// takes O ( sqrt n ) steps, while only touching the elements on the
+// staircases.
+template<typename Compare, typename SizeType, typename Layout, typename Key, typename Fn>
+void staircases ( Layout const & l_, basic_span_type<SizeType> const & last_, SizeType len_, Key const & lo_, Key const & hi_, Fn f_ ) {
+    if ( BEAP_UNLIKELY ( not len_ ) )
+        return;
+    SizeType const h = last_.end - last_.beg, c = len_ - last_.beg; // The last row, and its length.
+    SizeType l = h + 1, u = h + 1;
+    for ( SizeType b = 0; b <= h; ++b ) {
+        SizeType const n = h - b + ( b < c ); // The length of column b.
+        l = std::min ( l, n ), u = std::min ( u, n );
+        while ( l and less_than<Compare> ( l_.key ( matrix_at ( l_, l - 1, b ) ), lo_ ) )
+            --l;
+        if ( BEAP_UNLIKELY ( not l ) ) // As it is in all columns to the right.
+            break;
+        while ( u and not less_than<Compare> ( hi_, l_.key ( matrix_at ( l_, u - 1, b ) ) ) )
+            --u;
+        f_ ( b, u, l );
+    }
+}
+
+// Calls f_ with every element in [ lo_, hi_ ] (lo_ not ordered after hi_ by
+// Compare), column by column of the matrix view (in no particular order),
+// in O ( sqrt n + k ) for k elements, instead of the O ( n ) of a scan.
+// Measured on random ints (ns, 1M keys): 8700 for a range of about 1
+// element, 22700 for one of 10000, against 910000 for a scan.
+template<typename Compare, typename SizeType, typename Layout, typename Key, typename Fn>
+void for_each_in_range ( Layout const & l_, basic_span_type<SizeType> const & last_, SizeType len_, Key const & lo_, Key const & hi_, Fn f_ ) {
+    staircases<Compare> ( l_, last_, len_, lo_, hi_, [ &l_, &f_ ] ( SizeType b_, SizeType u_, SizeType e_ ) {
+        for ( SizeType a = u_; a < e_; ++a )
+            f_ ( matrix_at ( l_, a, b_ ) );
+    } );
+}
+
+// Walks the staircase of the elements e for which not below_ ( key ( e ) ),
+// below_ being false on a prefix of every column, in O ( sqrt n ). Calls
+// f_ ( b, l, n ) for every column b of length n, the staircase covering
+// [ 0, l ) of it, up to and including the first column with l = 0.
+template<typename SizeType, typename Layout, typename Below, typename Fn>
+void staircase ( Layout const & l_, basic_span_type<SizeType> const & last_, SizeType len_, Below below_, Fn f_ ) {
+    if ( BEAP_UNLIKELY ( not len_ ) )
+        return;
+    SizeType const h = last_.end - last_.beg, c = len_ - last_.beg;
+    SizeType l = h + 1;
+    for ( SizeType b = 0; b <= h; ++b ) {
+        SizeType const n = h - b + ( b < c );
+        l                = std::min ( l, n );
+        while ( l and below_ ( l_.key ( matrix_at ( l_, l - 1, b ) ) ) )
+            --l;
+        f_ ( b, l, n );
+        if ( BEAP_UNLIKELY ( not l ) )
+            break;
+    }
+}
+
+// The number of elements e for which not below_ ( key ( e ) ).
+template<typename SizeType, typename Layout, typename Below>
+[[nodiscard]] SizeType staircase_size ( Layout const & l_, basic_span_type<SizeType> const & last_, SizeType len_, Below below_ ) {
+    SizeType r = 0;
+    staircase ( l_, last_, len_, below_, [ &r ] ( SizeType, SizeType e_, SizeType ) noexcept { r += e_; } );
+    return r;
+}
+
+// The number of elements ordered after k_ (greater, by std::less), before
+// k_, and in [ lo_, hi_ ] (none if hi_ is ordered before lo_), summed over
+// the staircases in O ( sqrt n ), without visiting the elements counted.
+// Measured on random ints (ns, 100K / 1M keys): count_greater ( ) 2050 /
+// 8200, count_between ( ) 4270 / 16000, against 147000 / 1700000 for
+// std::count_if.
+template<typename Compare, typename SizeType, typename Layout, typename Key>
+[[nodiscard]] SizeType count_greater ( Layout const & l_, basic_span_type<SizeType> const & last_, SizeType len_, Key const & k_ ) {
+    return staircase_size ( l_, last_, len_, [ &k_ ] ( Key const & e_ ) noexcept { return not less_than<Compare> ( k_, e_ ); } );
+}
+template<typename Compare, typename SizeType, typename Layout, typename Key>
+[[nodiscard]] SizeType count_less ( Layout const & l_, basic_span_type<SizeType> const & last_, SizeType len_, Key const & k_ ) {
+    return len_ - staircase_size ( l_, last_, len_, [ &k_ ] ( Key const & e_ ) noexcept { return less_than<Compare> ( e_, k_ ); } );
+}
+template<typename Compare, typename SizeType, typename Layout, typename Key>
+[[nodiscard]] SizeType count_between ( Layout const & l_, basic_span_type<SizeType> const & last_, SizeType len_, Key const & lo_, Key const & hi_ ) {
+    SizeType r = 0;
+    staircases<Compare> ( l_, last_, len_, lo_, hi_, [ &r ] ( SizeType, SizeType u_, SizeType e_ ) noexcept { r += std::max ( e_ - u_, SizeType{ 0 } ); } );
+    return r;
+}
+
+// Element i_, of which the row is worked out, for the walks that give indices.
+template<typename SizeType, typename Layout>
+[[nodiscard]] decltype ( auto ) element_at ( Layout const & l_, SizeType i_ ) noexcept {
+    return l_.at ( i_, basic_span_type<SizeType>::span ( nth_triangular_root ( i_ + 1 ) - 1 ) );
+}
+
+// The indices of the least (by Compare) of the elements e for which not
+// below_ ( key ( e ) ), the least of the lowest elements of the staircase
+// in the columns, and of the greatest of the others, the greatest of the
+// highest elements under it, either being len_ if there are none, or if
+// not asked for (by Least and Greatest).
+template<typename Compare, bool Least, bool Greatest, typename SizeType, typename Layout, typename Below>
+[[nodiscard]] std::pair<SizeType, SizeType> bounds ( Layout const & l_, basic_span_type<SizeType> const & last_, SizeType len_, Below below_ ) {
+    using element = std::remove_reference_t<decltype ( matrix_at ( l_, len_, len_ ) )>;
+    SizeType u = len_, l = len_;
+    element *pu = nullptr, *pl = nullptr; // Elements u and l, to compare with.
+    staircase ( l_, last_, len_, below_, [ & ] ( SizeType b_, SizeType e_, SizeType n_ ) noexcept {
+        if constexpr ( Least )
+            if ( e_ ) {
+                element & c = matrix_at ( l_, e_ - 1, b_ );
+                if ( not pu or less_than<Compare> ( l_.key ( c ), l_.key ( *pu ) ) )
+                    pu = std::addressof ( c ), u = nth_triangular ( e_ - 1 + b_ ) + b_;
+            }
+        if constexpr ( Greatest )
+            if ( e_ < n_ ) {
+                element & c = matrix_at ( l_, e_, b_ );
+                if ( not pl or less_than<Compare> ( l_.key ( *pl ), l_.key ( c ) ) )
+                    pl = std::addressof ( c ), l = nth_triangular ( e_ + b_ ) + b_;
+            }
+    } );
+    return { u, l };
+}
+
+// The index of the least element not ordered before k_ (by Compare, the
+// smallest element >= k_, by std::less), of the least element ordered
+// after k_ (> k_), and of the greatest element not ordered after k_ (<=
+// k_), or len_ if there is none. One walk along a staircase, in O ( sqrt
+// n ), like search ( ), which keeps the best candidate of every column.
+// Measured on random ints (ns, 100K / 1M keys): lower_bound ( ) 3200 /
+// 9700 and nearest ( ) 3700 / 11500, against find ( ) 1900 / 7300 and a
+// scan 150000 / 1600000.
+template<typename Compare, typename SizeType, typename Layout, typename Key>
+[[nodiscard]] SizeType lower_bound ( Layout const & l_, basic_span_type<SizeType> const & last_, SizeType len_, Key const & k_ ) {
+    return bounds<Compare, true, false> ( l_, last_, len_, [ &k_ ] ( Key const & e_ ) noexcept { return less_than<Compare> ( e_, k_ ); } ).first;
+}
+template<typename Compare, typename SizeType, typename Layout, typename Key>
+[[nodiscard]] SizeType upper_bound ( Layout const & l_, basic_span_type<SizeType> const & last_, SizeType len_, Key const & k_ ) {
+    return bounds<Compare, true, false> ( l_, last_, len_, [ &k_ ] ( Key const & e_ ) noexcept { return not less_than<Compare> ( k_, e_ ); } ).first;
+}
+template<typename Compare, typename SizeType, typename Layout, typename Key>
+[[nodiscard]] SizeType floor ( Layout const & l_, basic_span_type<SizeType> const & last_, SizeType len_, Key const & k_ ) {
+    return bounds<Compare, false, true> ( l_, last_, len_, [ &k_ ] ( Key const & e_ ) noexcept { return not less_than<Compare> ( k_, e_ ); } ).second;
+}
+
+// The index of the element closest to k_, or len_ if empty, of the least
+// element not ordered before k_ and the greatest element ordered before
+// it, found in one walk, the former on a tie. The distance is the absolute
+// difference, so the keys are numbers, time points or the like.
+template<typename Compare, typename SizeType, typename Layout, typename Key>
+[[nodiscard]] SizeType nearest ( Layout const & l_, basic_span_type<SizeType> const & last_, SizeType len_, Key const & k_ ) {
+    auto const [ u, l ] = bounds<Compare, true, true> ( l_, last_, len_, [ &k_ ] ( Key const & e_ ) noexcept { return less_than<Compare> ( e_, k_ ); } );
+    if ( u == len_ or l == len_ )
+        return u == len_ ? l : u;
+    auto distance = [ &k_ ] ( Key const & e_ ) { return e_ < k_ ? k_ - e_ : e_ - k_; };
+    return distance ( l_.key ( element_at ( l_, l ) ) ) < distance ( l_.key ( element_at ( l_, u ) ) ) ? l : u;
+}
+
+// The indices of the elements with key k_ (in no particular order).
+// Elements with the same key form a band between two staircases, so this
+// takes O ( sqrt n + k ) for k of them, instead of a scan.
+template<typename Compare, typename SizeType, typename Layout, typename Key>
+[[nodiscard]] std::vector<SizeType> equal_range ( Layout const & l_, basic_span_type<SizeType> const & last_, SizeType len_, Key const & k_ ) {
+    std::vector<SizeType> r;
+    staircases<Compare> ( l_, last_, len_, k_, k_, [ &r ] ( SizeType b_, SizeType u_, SizeType e_ ) {
+        for ( SizeType a = u_; a < e_; ++a )
+            r.push_back ( nth_triangular ( a + b_ ) + b_ );
+    } );
+    return r;
+}
+
+// Erases every element with key k_ from b_, and returns how many. The
+// copies are found along the staircases, after which few are erased by
+// index, from the back (those the sifts moved meanwhile are searched for),
+// many by rebuild_ ( ), which drops them all and rebuilds the beap, see
+// rebuild_is_cheaper ( ). Measured on 1M random ints (ms): 0.11 for 10
+// copies, 4.9 for 1000 and 11 for 50000 (rebuilt), against 0.18, 12 and
+// 297 for a search and an erase per copy.
+template<typename Compare, typename Beap, typename Key, typename Rebuild>
+typename Beap::size_type erase_all ( Beap & b_, Key const & k_, Rebuild rebuild_ ) {
+    using size_type           = typename Beap::size_type;
+    std::vector<size_type> is = b_.equal_range ( k_ );
+    size_type const k         = static_cast<size_type> ( is.size ( ) );
+    if ( BEAP_UNLIKELY ( not k ) )
+        return 0;
+    if ( rebuild_is_cheaper ( b_.length ( ) - k, k ) ) {
+        rebuild_ ( );
+    }
+    else {
+        // From the back, so that most copies are still where they were found.
+        std::sort ( is.begin ( ), is.end ( ), std::greater<size_type> ( ) );
+        size_type left = k;
+        for ( size_type i : is )
+            if ( i < b_.length ( ) and not three_way<Compare> ( b_[ i ].key ( ), k_ ) )
+                b_.erase_by_index ( i ), --left;
+        for ( ; left; --left )
+            b_.erase ( k_ );
+    }
+    return k;
+}
+
+// The element of rank k_, the k_-th in descending order (by Compare), so
+// that select ( 0 ) is the top, leaving the beap as is. Selection in the
+// matrix view, as a sorted matrix (after Frederickson and Johnson): every
+// column keeps a window [ lo, hi ) of candidates, of which one, the pivot,
+// is drawn at random (from a generator seeded by k_, so the result is
+// repeatable).
+// Walking its two staircases (see staircases ( )) through the windows
+// counts the elements ordered after it and those not ordered before it,
+// which either gives the pivot, or shrinks the windows to the candidates
+// on the side of rank k_, until no more candidates than columns are left,
+// which are passed (by address) to std::nth_element. That takes O ( log n )
+// rounds, expected, of O ( sqrt n ) steps. Measured on random ints (ns,
+// 100K / 1M keys): 85000 / 315000, against 410000 / 4100000 for copying
+// the beap and std::nth_element.
+template<typename Compare, typename SizeType, typename Layout>
+[[nodiscard]] auto select ( Layout const & l_, basic_span_type<SizeType> const & last_, SizeType len_, SizeType k_ )
+    -> decltype ( matrix_at ( l_, k_, k_ ) ) {
+    using element = std::remove_reference_t<decltype ( matrix_at ( l_, k_, k_ ) )>;
+    assert ( 0 <= k_ and k_ < len_ );
+    SizeType const h = last_.end - last_.beg, c = len_ - last_.beg;
+    std::vector<SizeType> lo ( h + 1, 0 ), hi ( h + 1 ), gt ( h + 1 ), ge ( h + 1 );
+    SizeType m = 0; // The number of candidates.
+    for ( SizeType b = 0; b <= h; ++b )
+        m += hi[ b ] = h - b + ( b < c );
+    std::uint64_t r = static_cast<std::uint64_t> ( k_ );
+    while ( m > h + 1 ) {
+        r += 0x9E37'79B9'7F4A'7C15; // splitmix64.
+        std::uint64_t z = ( r ^ ( r >> 30 ) ) * 0xBF58'476D'1CE4'E5B9;
+        z               = ( z ^ ( z >> 27 ) ) * 0x94D0'49BB'1331'11EB;
+        SizeType i = static_cast<SizeType> ( ( z ^ ( z >> 31 ) ) % static_cast<std::uint64_t> ( m ) ), p = 0;
+        while ( i >= hi[ p ] - lo[ p ] )
+            i -= hi[ p ] - lo[ p ], ++p;
+        element & pivot = matrix_at ( l_, lo[ p ] + i, p );
+        // The elements above a window are ordered after, and those below it
+        // before, every candidate, so the staircases of the pivot run
+        // through the windows.
+        SizeType g = h + 1, e = h + 1, n_gt = 0, n_ge = 0;
+        for ( SizeType b = 0; b <= h; ++b ) {
+            g = std::min ( g, hi[ b ] ), e = std::min ( e, hi[ b ] );
+            while ( g > lo[ b ] and not less_than<Compare> ( l_.key ( pivot ), l_.key ( matrix_at ( l_, g - 1, b ) ) ) )
+                --g;
+            while ( e > lo[ b ] and less_than<Compare> ( l_.key ( matrix_at ( l_, e - 1, b ) ), l_.key ( pivot ) ) )
+                --e;
+            n_gt += gt[ b ] = g, n_ge += ge[ b ] = e;
+        }
+        if ( k_ < n_gt )
+            std::swap ( hi, gt );
+        else if ( k_ < n_ge )
+            return pivot;
+        else
+            std::swap ( lo, ge );
+        m = 0;
+        for ( SizeType b = 0; b <= h; ++b )
+            m += hi[ b ] - lo[ b ];
+    }
+    // As few candidates as columns are left, select from those.
+    std::vector<element *> w;
+    w.reserve ( m );
+    for ( SizeType b = 0; b <= h; ++b ) {
+        k_ -= lo[ b ];
+        for ( SizeType a = lo[ b ]; a < hi[ b ]; ++a )
+            w.push_back ( std::addressof ( matrix_at ( l_, a, b ) ) );
+    }
+    std::nth_element ( w.begin ( ), w.begin ( ) + k_, w.end ( ),
+                       [ &l_ ] ( element * a_, element * b_ ) noexcept { return less_than<Compare> ( l_.key ( *b_ ), l_.key ( *a_ ) ); } );
+    return *w[ k_ ];
+}
+
+// The walks of k keys_ (of which done_ ( k, i ) is told the index i found for
+// key k) are taken in sorted order, so that consecutive walks follow
+// neighbouring staircases and mostly hit cache lines (and pages) the
+// previous walk brought in. With Group > 1, that many walks are interleaved,
+// after each step the next element of a walk is prefetched and the other
+// walks take their step while that load is in flight (AMAC). That hides
+// nothing on an out-of-order core though, where the (well predicted)
+// scalar walk already runs ahead speculatively, interleaving breaks that
+// and the stride prefetcher. Measured on random ints (ns/key, 100K / 1M /
+// 10M keys): scalar 460 / 1700 / 7800, sorted 390 / 1370 / 5200, sorted,
+// interleaved by 8: 1050 / 3250 / 9700 (16 and 32 are no better). With
+// Group = 1, the walks are search_ ( key ), which returns the index.
+template<std::size_t Group, bool Padded, typename Compare, typename SizeType, typename Layout, typename Key, typename Search, typename Done>
+void search_batch ( Layout const & l_, basic_span_type<SizeType> const & last_, SizeType len_, std::span<Key const> keys_,
+                    Search const & search_, Done done_ ) {
+    std::size_t const n = keys_.size ( );
+    if ( BEAP_UNLIKELY ( not len_ ) ) {
+        for ( std::size_t k = 0; k < n; ++k )
+            done_ ( k, len_ );
+        return;
+    }
+    std::vector<std::uint32_t> order ( n );
+    std::iota ( order.begin ( ), order.end ( ), std::uint32_t{ 0 } );
+    std::sort ( order.begin ( ), order.end ( ),
+                [ keys_ ] ( std::uint32_t a_, std::uint32_t b_ ) noexcept { return less_than<Compare> ( keys_[ a_ ], keys_[ b_ ] ); } );
+    if constexpr ( Group == 1 ) {
+        for ( std::uint32_t k : order )
+            done_ ( k, search_ ( keys_[ k ] ) );
+    }
+    else {
+        using span_type = basic_span_type<SizeType>;
+        struct walk {
+            Key const * v; // Keys need not be default constructible.
+            span_type s = { 0, -1 };
+            SizeType i, h;
+            std::uint32_t k;
+        };
+        walk w[ Group ];
+        std::size_t next = 0, active = 0;
+        auto start = [ & ] ( walk & w_ ) noexcept {
+            std::uint32_t const k = order[ next++ ];
+            w_                    = { std::addressof ( keys_[ k ] ), last_, last_.beg, last_.end - last_.beg, k };
+            BEAP_PREFETCH ( std::addressof ( l_.at ( w_.i, w_.s ) ) );
+        };
+        while ( active < Group and next < n )
+            start ( w[ active++ ] );
+        while ( active ) {
+            for ( std::size_t j = 0; j < active; ) {
+                walk & x = w[ j ];
+                auto c   = [ &l_, v = x.v ] ( SizeType i_, span_type const & s_ ) noexcept { return three_way<Compare> ( *v, l_.key ( l_.at ( i_, s_ ) ) ); };
+                if ( BEAP_LIKELY ( not search_step<Padded> ( c, x.s, x.i, x.h, len_, last_ ) ) ) {
+                    BEAP_PREFETCH ( std::addressof ( l_.at ( x.i, x.s ) ) );
+                    ++j;
+                    continue;
+                }
+                done_ ( x.k, x.i );
+                if ( next < n )
+                    start ( x ), ++j;
+                else
+                    x = w[ --active ];
+            }
+        }
+    }
+}
+
+// Bubbling up k_ keys into a beap of n_ costs some k sqrt ( 2 ( n + k ) )
+// steps at worst, a rebuild some ( n + k ) log2 ( n + k ), both measured at
+// 1.5 .. 3.5 ns/step.
+template<typename SizeType>
+[[nodiscard]] bool rebuild_is_cheaper ( SizeType n_, SizeType k_ ) noexcept {
+    std::int64_t const m = static_cast<std::int64_t> ( n_ ) + k_;
+    return static_cast<std::int64_t> ( k_ ) * nth_triangular_root ( static_cast<SizeType> ( m ) ) >
+           m * static_cast<std::int64_t> ( std::bit_width ( static_cast<std::uint64_t> ( m ) ) );
+}
+
+} // namespace tri
@@ -0,0 +1,333 @@
+// MIT License
+//
+// Copyright (c) 2020 degski
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, rhs_, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+
+#include <algorithm>
+#include <bit>
+#include <compare>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <numeric>
+#include <span>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "detail/hedley.hpp"
+
+#define BEAP_PURE HEDLEY_PURE
+#define BEAP_UNPREDICTABLE HEDLEY_UNPREDICTABLE
+#define BEAP_LIKELY HEDLEY_LIKELY
+#define BEAP_UNLIKELY HEDLEY_UNLIKELY
+#if defined( _MSC_VER ) && not defined( __clang__ )
+#    include <intrin.h>
+#    define BEAP_PREFETCH( p ) _mm_prefetch ( reinterpret_cast<char const *> ( p ), _MM_HINT_T0 )
+#else
+#    define BEAP_PREFETCH( p ) __builtin_prefetch ( p )
+#endif
+
+#include "detail/triangular.hpp"
+#include "detail/search.hpp"
+#include "detail/simd_search.hpp"
+#include "detail/walk.hpp"
+
+template<typename Key, typename Payload, typename SignedSizeType = int32_t, typename Compare = std::less<Key>>
+class keyed_beap {
+
+    // The beap of beap.hpp, split in two parallel arrays (structure of arrays),
+    // keys [ i ] and payloads [ i ] being element i of the triangular lay-out.
+    // The searches and the sifts compare keys only, so their walks stay in the
+    // dense key array, a payload is moved only when its element changes
+    // position. Measured on 8-byte keys with 56-byte payloads (ns/key, 100K /
+    // 1M / 10M keys), against a beap of the 64-byte records projected onto
+    // their key: find 4230 / 21000 / 69200 -> 1930 / 11700 / 43300, insert
+    // 4000 / 16000 / 50000 -> 3600 / 19200 / 73400, pop 10220 / 52000 / 192000
+    // -> 9470 / 58500 / 265000. The sifts pay for a second cache line per row,
+    // that of the payload, so keyed_beap is the better choice for lookups at
+    // any size, but where inserts and pops dominate only up to about 100K
+    // elements, beyond that a beap of the records (see tri::member) is faster.
+
+    public:
+    using size_type   = SignedSizeType;
+    using key_type    = Key;
+    using mapped_type = Payload;
+
+    private:
+    using span_type = tri::basic_span_type<size_type>;
+
+    public:
+    keyed_beap ( ) noexcept              = default;
+    keyed_beap ( keyed_beap const & b_ ) : keys ( b_.keys ), payloads ( b_.payloads ), end_span ( b_.end_span ) { reserve_path ( end_span ); }
+    keyed_beap ( keyed_beap && b_ ) = default;
+
+    // Constructing from the ranges of keys and (as many) payloads builds the beap in O ( n log n ), see make_beap ( ).
+    template<typename KeyIt, typename PayloadIt>
+    keyed_beap ( KeyIt kb_, KeyIt ke_, PayloadIt pb_ ) : keys ( kb_, ke_ ), payloads ( pb_, std::next ( pb_, keys.size ( ) ) ) {
+        make_beap ( );
+    }
+
+    [[maybe_unused]] keyed_beap & operator= ( keyed_beap const & b_ ) {
+        keyed_beap b ( b_ );
+        swap ( b );
+        return *this;
+    }
+    [[maybe_unused]] keyed_beap & operator= ( keyed_beap && b_ ) = default;
+
+    // Operations (private).
+
+    private:
+    // The staircase walk of beap::search ( ), over the keys.
+    [[nodiscard]] span_type search ( key_type const & v ) const noexcept {
+        if constexpr ( simd_searchable )
+            return search_simd ( v );
+        else
+            return tri::search<false> ( compare_to ( v ), end_span, length ( ) );
+    }
+
+    [[nodiscard]] auto compare_to ( key_type const & v_ ) const noexcept {
+        return [ this, &v_ ] ( size_type i_, span_type const & ) noexcept { return tri::three_way<Compare> ( v_, keys[ i_ ] ); };
+    }
+
+    // See beap::search_simd ( ), the keys are contiguous.
+    static constexpr bool simd_searchable = tri::simd::enabled_v<Key, Compare>;
+
+    [[nodiscard]] span_type search_simd ( key_type const & v ) const noexcept {
+        Key const * const p = keys.data ( );
+        size_type const len = length ( );
+        return tri::search_scanning<false> (
+            compare_to ( v ),
+            [ p, len, &v ] ( size_type i_, size_type h_, size_type e_ ) noexcept {
+                return tri::simd::scan<tri::simd::order_v<Key, Compare>> ( p, len, i_, h_, e_, v );
+            },
+            end_span, len );
+    }
+
+    [[nodiscard]] bool less ( key_type const & a_, key_type const & b_ ) const noexcept { return tri::less_than<Compare> ( a_, b_ ); }
+
+    // The sifts move the keys only, and note the path of the hole, along which
+    // the payloads are then rotated in one go. Their loads then do not hold up
+    // the walk over the keys, and they are independent, so they overlap.
+    struct layout {
+        keyed_beap & b;
+        key_type * const k = b.keys.data ( ); // Cached, as the pushes onto path would have it reloaded.
+        [[nodiscard]] BEAP_PURE key_type & at ( size_type i_, span_type const & ) const noexcept { return k[ i_ ]; }
+        [[nodiscard]] static key_type const & key ( key_type const & k_ ) noexcept { return k_; }
+        void placed ( size_type i_, span_type const & ) noexcept { b.path.push_back ( i_ ); } // See reserve_path ( ).
+    };
+
+    // A sift writes once per row it passes, so the path is at most as long as
+    // there are rows (up to last_), with that reserved, the noexcept sifts do
+    // not allocate.
+    void reserve_path ( span_type const & last_ ) { path.reserve ( last_.end - last_.beg + 1 ); }
+
+    // The path holds the hole, then the elements moved into it, in order.
+    void rotate_payloads ( ) noexcept {
+        if ( path.size ( ) > 1 ) {
+            size_type i   = path.front ( );
+            mapped_type p = std::move ( payloads[ i ] );
+            for ( size_type f : std::span ( path ).subspan ( 1 ) )
+                payloads[ i ] = std::move ( payloads[ f ] ), i = f;
+            payloads[ i ] = std::move ( p );
+        }
+        path.clear ( );
+    }
+
+    [[maybe_unused]] size_type bubble_up ( size_type i_, size_type h_ ) noexcept {
+        assert ( path.capacity ( ) > static_cast<std::size_t> ( end_span.end - end_span.beg ) );
+        layout l{ *this };
+        size_type const i = tri::sift_up<Compare, tri::sift_prefetch_distance> ( l, i_, h_, tri::sift_prefetches ( length ( ) ) );
+        rotate_payloads ( );
+        return i;
+    }
+
+    [[nodiscard]] size_type bubble_down ( size_type i_, size_type h_ ) noexcept {
+        assert ( path.capacity ( ) > static_cast<std::size_t> ( end_span.end - end_span.beg ) );
+        layout l{ *this };
+        size_type const i = tri::sift_down<Compare, false, tri::sift_prefetch_distance> ( l, i_, h_, end_span.end - end_span.beg, length ( ), tri::sift_prefetches ( length ( ) ) );
+        rotate_payloads ( );
+        return i;
+    }
+
+    [[maybe_unused]] void erase_impl ( size_type i_, size_type h_ ) noexcept {
+        size_type len = length ( );
+        if ( BEAP_UNLIKELY ( ( len - 1 ) == end_span.beg ) )
+            --end_span;
+        if ( BEAP_UNLIKELY ( i_ == ( len - 1 ) ) ) {
+            pop_back ( );
+            return;
+        }
+        keys[ i_ ]     = std::move ( keys.back ( ) );
+        payloads[ i_ ] = std::move ( payloads.back ( ) );
+        pop_back ( );
+        if ( size_type i = bubble_down ( i_, h_ ); BEAP_LIKELY ( i == i_ ) )
+            bubble_up ( i_, h_ );
+    }
+
+    void pop_back ( ) noexcept {
+        keys.pop_back ( );
+        payloads.pop_back ( );
+    }
+
+    // Operations (public).
+
+    public:
+    // Constructs the payload in place, from args_ (forwarded to the constructor of Payload).
+    // If that (or any allocation) throws, the beap is left as it was.
+    template<typename... Args>
+    [[maybe_unused]] size_type emplace ( key_type k_, Args &&... args_ ) {
+        size_type i = length ( );
+        bool const grow   = i > end_span.end;
+        span_type const s = grow ? end_span.next ( ) : end_span;
+        keys.reserve ( s.end + 1 );
+        payloads.reserve ( s.end + 1 );
+        reserve_path ( s );
+        payloads.emplace_back ( std::forward<Args> ( args_ )... );
+        try {
+            keys.push_back ( std::move ( k_ ) ); // Does not allocate, but the key might throw on moving.
+        }
+        catch ( ... ) {
+            payloads.pop_back ( );
+            throw;
+        }
+        if ( BEAP_UNLIKELY ( grow ) )
+            end_span = s;
+        return bubble_up ( i, end_span.end - end_span.beg );
+    }
+    [[maybe_unused]] size_type insert ( key_type k_, mapped_type p_ ) { return emplace ( std::move ( k_ ), std::move ( p_ ) ); }
+
+    void erase ( key_type const & k_ ) noexcept {
+        auto [ i, h ] = search ( k_ );
+        if ( BEAP_UNLIKELY ( i == length ( ) ) )
+            return;
+        erase_impl ( i, h );
+    }
+    void erase_by_index ( size_type i_ ) noexcept {
+        if ( BEAP_UNLIKELY ( i_ >= length ( ) ) )
+            return;
+        erase_impl ( i_, tri::nth_triangular_root ( i_ + 1 ) - 1 );
+    }
+
+    // The index of (an element with) key k_, or length ( ) if absent.
+    [[nodiscard]] size_type find ( key_type const & k_ ) const noexcept { return search ( k_ ).beg; }
+    [[nodiscard]] bool contains ( key_type const & k_ ) const noexcept { return find ( k_ ) != length ( ); }
+
+    // Element i_, as found by find ( ), indices are valid until the next change.
+    [[nodiscard]] BEAP_PURE key_type const & key ( size_type i_ ) const noexcept { return keys[ i_ ]; }
+    [[nodiscard]] BEAP_PURE mapped_type const & payload ( size_type i_ ) const noexcept { return payloads[ i_ ]; }
+    [[nodiscard]] BEAP_PURE mapped_type & payload ( size_type i_ ) noexcept { return payloads[ i_ ]; }
+
+    // Sizes.
+
+    [[nodiscard]] BEAP_PURE size_type size ( ) const noexcept { return static_cast<size_type> ( keys.size ( ) ); }
+    [[nodiscard]] BEAP_PURE size_type length ( ) const noexcept { return size ( ); }
+    [[nodiscard]] BEAP_PURE size_type capacity ( ) const noexcept { return static_cast<size_type> ( keys.capacity ( ) ); }
+
+    // Beap.
+
+    // As beap::make_beap ( ), the keys are sorted along with an index, by which
+    // the payloads are then permuted.
+    void make_beap ( ) {
+        assert ( keys.size ( ) == payloads.size ( ) );
+        std::vector<size_type> order ( keys.size ( ) );
+        std::iota ( order.begin ( ), order.end ( ), size_type{ 0 } );
+        std::sort ( order.begin ( ), order.end ( ),
+                    [ this ] ( size_type a_, size_type b_ ) noexcept { return less ( keys[ b_ ], keys[ a_ ] ); } );
+        std::vector<key_type> k;
+        std::vector<mapped_type> p;
+        k.reserve ( keys.size ( ) );
+        p.reserve ( keys.size ( ) );
+        for ( size_type i : order ) {
+            k.push_back ( std::move ( keys[ i ] ) );
+            p.push_back ( std::move ( payloads[ i ] ) );
+        }
+        keys     = std::move ( k );
+        payloads = std::move ( p );
+        end_span = span_type::span ( tri::nth_triangular_root ( size ( ) ) - 1 );
+        reserve_path ( end_span );
+    }
+
+    template<typename KeyRange, typename PayloadRange>
+    [[nodiscard]] static keyed_beap build ( KeyRange const & k_, PayloadRange const & p_ ) {
+        assert ( std::size ( k_ ) == std::size ( p_ ) );
+        return keyed_beap ( std::begin ( k_ ), std::end ( k_ ), std::begin ( p_ ) );
+    }
+
+    // Returns the top element, and removes it.
+    [[nodiscard]] std::pair<key_type, mapped_type> pop_beap ( ) noexcept {
+        std::pair<key_type, mapped_type> t{ std::move ( keys.front ( ) ), std::move ( payloads.front ( ) ) };
+        erase_impl ( 0, 0 );
+        return t;
+    }
+    [[maybe_unused]] size_type push_beap ( key_type k_, mapped_type p_ ) { return insert ( std::move ( k_ ), std::move ( p_ ) ); }
+
+    [[nodiscard]] BEAP_PURE key_type const & top_key ( ) const noexcept { return keys.front ( ); }
+    [[nodiscard]] BEAP_PURE mapped_type const & top ( ) const noexcept { return payloads.front ( ); }
+    [[nodiscard]] BEAP_PURE mapped_type & top ( ) noexcept { return payloads.front ( ); }
+
+    // The index of the bottom (minimal) element.
+    [[nodiscard]] BEAP_PURE size_type bottom ( ) const noexcept {
+        return tri::bottom ( [ this ] ( size_type i_, size_type j_ ) noexcept { return less ( keys[ i_ ], keys[ j_ ] ); }, end_span, size ( ) );
+    }
+
+    [[nodiscard]] size_type is_beap_untill ( ) const noexcept {
+        return tri::is_beap_untill ( [ this ] ( size_type i_, size_type j_ ) noexcept { return less ( keys[ i_ ], keys[ j_ ] ); }, size ( ) );
+    }
+
+    // Miscelanious.
+
+    void clear ( ) noexcept {
+        keys.clear ( );
+        payloads.clear ( );
+        end_span = { 0, -1 };
+    }
+    [[nodiscard]] constexpr size_type max_size ( ) const noexcept { return std::numeric_limits<size_type>::max ( ); }
+
+    void swap ( keyed_beap & rhs_ ) noexcept {
+        std::swap ( keys, rhs_.keys );
+        std::swap ( payloads, rhs_.payloads );
+        std::swap ( path, rhs_.path );
+        std::swap ( end_span, rhs_.end_span );
+    }
+
+    [[nodiscard]] bool empty ( ) const noexcept { return keys.empty ( ); }
+
+    // Members.
+
+    private:
+    std::vector<key_type> keys;
+    std::vector<mapped_type> payloads;
+    std::vector<size_type> path; // Of the last sift, see rotate_payloads ( ).
+    span_type end_span = { 0, -1 };
+};
+
+#undef BEAP_PURE
+#undef BEAP_UNPREDICTABLE
+#undef BEAP_LIKELY
+#undef BEAP_UNLIKELY
+#undef BEAP_PREFETCH
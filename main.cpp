@@ -203,31 +203,3 @@ int main ( ) {
   None
 */
 
-#if 0
-
-int main ( ) {
-
-    constexpr int size = 1'024;
-
-    sax::splitmix64 rng{ [] ( ) {
-        std::random_device rdev;
-        return ( static_cast<std::size_t> ( rdev ( ) ) << 32 ) | static_cast<std::size_t> ( rdev ( ) );
-    }( ) };
-    sax::uniform_int_distribution<int> dis_lev{ 3, size * size - 1 };
-    sax::uniform_int_distribution<std::size_t> dis_idx{ 0, size - 1 };
-
-    plf::nanotimer t;
-
-    t.start ( );
-
-    for ( int i = 0; i < size * size; ++i ) {
-    }
-
-    uint64_t time = static_cast<uint64_t> ( t.get_elapsed_ms ( ) );
-
-    std::cout << time << " ms " << nl;
-
-    return EXIT_SUCCESS;
-}
-
-#endif